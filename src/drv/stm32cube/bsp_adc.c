@@ -12,7 +12,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
-#include "ch.h"
+#include "hal.h"
 #include "bsp_adc.h"
 #include "bsp_adc_conf.h"
 #include "bsp_trigger.h"
@@ -25,6 +25,28 @@ static ADC_ChannelConfTypeDef adc_chan_conf[NB_ADC];
 
 extern void DelayUs(uint32_t delay_us);
 
+/* ADC conversion is sampling time + 12 ADCCLK cycles */
+#define ADC_CLK_DIV (4)
+#define ADC_CONV_CYCLES (12)
+#define ADC_FAST_SAMPLETIME ADC_SAMPLETIME_3CYCLES
+#define ADC_FAST_CYCLES (3)
+/* Internal channels need at least 10us sampling time */
+#define ADC_INTERNAL_SAMPLETIME ADC_SAMPLETIME_480CYCLES
+#define ADC_INTERNAL_CYCLES (480)
+
+/* Timer triggered DMA streaming or capture window */
+static struct {
+	const stm32_dma_stream_t* dma;
+	binary_semaphore_t sem; /* Signaled on DMA half/full transfer */
+	uint16_t* samples;
+	uint32_t size; /* DMA transfer size in samples */
+	uint32_t half_size; /* Number of samples per half buffer */
+	volatile uint32_t produced; /* Half buffers filled, written by DMA ISR */
+	uint32_t consumed;
+	uint32_t drops;
+	bool active;
+} adc_stream;
+
 /** \brief ADC GPIO HW DeInit.
  *
  * \param dev_num bsp_dev_adc_t: ADC dev num
@@ -57,6 +79,99 @@ static void adc_gpio_hw_init(bsp_dev_adc_t dev_num)
 	}
 }
 
+/** \brief Get ADC channel of a source.
+ *
+ * \param dev_num bsp_dev_adc_t: ADC dev num
+ * \return uint32_t: ADC_CHANNEL_xxx
+ *
+ */
+static uint32_t adc_channel(bsp_dev_adc_t dev_num)
+{
+	switch(dev_num) {
+	case BSP_DEV_ADC1:
+		return ADC_CHANNEL_1;
+
+	case BSP_DEV_ADC_TEMPSENSOR :
+		return ADC_CHANNEL_TEMPSENSOR;
+
+	case BSP_DEV_ADC_VREFINT:
+		return ADC_CHANNEL_VREFINT;
+
+	case BSP_DEV_ADC_VBAT:
+		return ADC_CHANNEL_VBAT;
+
+	default:
+		return ADC_CHANNEL_TEMPSENSOR;
+	}
+}
+
+/** \brief Init ADC1 with a regular group of several sources converted in
+ * sequence (scan mode) with DMA requests.
+ *
+ * \param sources const bsp_dev_adc_t*: sources in conversion order.
+ * \param nb_sources uint8_t: number of sources (1 to 16).
+ * \param ext_trig uint32_t: ADC_SOFTWARE_START or ADC_EXTERNALTRIGCONV_xxx.
+ * \param seq_cycles uint32_t*: ADCCLK cycles for one sequence.
+ * \return bsp_status_t: status of the init.
+ *
+ */
+static bsp_status_t adc_scan_init(const bsp_dev_adc_t* sources, uint8_t nb_sources,
+				  uint32_t ext_trig, uint32_t* seq_cycles)
+{
+	ADC_HandleTypeDef* hadc;
+	ADC_ChannelConfTypeDef* hadc_chan;
+	uint8_t i;
+
+	if((nb_sources == 0) || (nb_sources > 16))
+		return BSP_ERROR;
+
+	bsp_adc_deinit(BSP_DEV_ADC1);
+	adc_gpio_hw_init(BSP_DEV_ADC1);
+	__ADC1_CLK_ENABLE();
+
+	hadc = &adc_handle[BSP_DEV_ADC1];
+	hadc->Instance = BSP_ADC1;
+	hadc->Init.ClockPrescaler = ADC_CLOCKPRESCALER_PCLK_DIV4;
+	hadc->Init.Resolution = ADC_RESOLUTION12b;
+	hadc->Init.ScanConvMode = (nb_sources > 1) ? ENABLE : DISABLE;
+	hadc->Init.ContinuousConvMode = DISABLE;
+	hadc->Init.DiscontinuousConvMode = DISABLE;
+	hadc->Init.NbrOfDiscConversion = 0;
+	if(ext_trig == ADC_SOFTWARE_START)
+		hadc->Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+	else
+		hadc->Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+	hadc->Init.ExternalTrigConv = ext_trig;
+	hadc->Init.DataAlign = ADC_DATAALIGN_RIGHT;
+	hadc->Init.NbrOfConversion = nb_sources;
+	hadc->Init.DMAContinuousRequests = ENABLE;
+	hadc->Init.EOCSelection = EOC_SEQ_CONV;
+
+	if(HAL_ADC_Init(hadc) != HAL_OK) {
+		return BSP_ERROR;
+	}
+
+	*seq_cycles = 0;
+	hadc_chan = &adc_chan_conf[BSP_DEV_ADC1];
+	for(i = 0; i < nb_sources; i++) {
+		hadc_chan->Channel = adc_channel(sources[i]);
+		hadc_chan->Rank = i + 1;
+		hadc_chan->Offset = 0;
+		if(sources[i] == BSP_DEV_ADC1) {
+			hadc_chan->SamplingTime = ADC_FAST_SAMPLETIME;
+			*seq_cycles += ADC_FAST_CYCLES + ADC_CONV_CYCLES;
+		} else {
+			hadc_chan->SamplingTime = ADC_INTERNAL_SAMPLETIME;
+			*seq_cycles += ADC_INTERNAL_CYCLES + ADC_CONV_CYCLES;
+		}
+		if(HAL_ADC_ConfigChannel(hadc, hadc_chan) != HAL_OK) {
+			return BSP_ERROR;
+		}
+	}
+
+	return BSP_OK;
+}
+
 /** \brief Init ADC device.
  *
  * \param dev_num bsp_dev_adc_t: ADC dev num.
@@ -102,27 +217,7 @@ bsp_status_t bsp_adc_init(bsp_dev_adc_t dev_num)
 	}
 
 	/* Configure ADC regular channel */
-	switch(dev_num) {
-	case BSP_DEV_ADC1:
-		adc_chan_num = ADC_CHANNEL_1;
-		break;
-
-	case BSP_DEV_ADC_TEMPSENSOR :
-		adc_chan_num = ADC_CHANNEL_TEMPSENSOR;
-		break;
-
-	case BSP_DEV_ADC_VREFINT:
-		adc_chan_num = ADC_CHANNEL_VREFINT;
-		break;
-
-	case BSP_DEV_ADC_VBAT:
-		adc_chan_num = ADC_CHANNEL_VBAT;
-		break;
-
-	default:
-		adc_chan_num = ADC_CHANNEL_TEMPSENSOR;
-		break;
-	}
+	adc_chan_num = adc_channel(dev_num);
 
 	hadc_chan = &adc_chan_conf[dev_num];
 	hadc_chan->Channel = adc_chan_num;
@@ -241,3 +336,284 @@ bsp_status_t bsp_adc_trigger(uint32_t low, uint32_t high, uint32_t delay)
 	bsp_adc_deinit(BSP_DEV_ADC1);
 	return status;
 }
+
+static void adc_stream_dma_cb(void* p, uint32_t flags)
+{
+	(void)p;
+
+	if(flags & STM32_DMA_ISR_HTIF)
+		adc_stream.produced++;
+	if(flags & STM32_DMA_ISR_TCIF)
+		adc_stream.produced++;
+
+	chSysLockFromISR();
+	chBSemSignalI(&adc_stream.sem);
+	chSysUnlockFromISR();
+}
+
+static void adc_timer_deinit(void)
+{
+	TIM_HandleTypeDef htim;
+
+	htim.Instance = BSP_ADC_STREAM_TIMER;
+	HAL_TIM_Base_DeInit(&htim);
+	__TIM3_FORCE_RESET();
+	__TIM3_RELEASE_RESET();
+}
+
+/** \brief Configure ADC1, DMA and timer for a timer triggered acquisition.
+ *
+ * \param sources const bsp_dev_adc_t*: sources converted at each trigger.
+ * \param nb_sources uint8_t: number of sources.
+ * \param sample_rate uint32_t*: sequences per second, set to the real rate.
+ * \param samples uint16_t*: DMA buffer (not in CCM).
+ * \param nb_samples uint32_t: DMA transfer size in samples.
+ * \param dma_mode uint32_t: STM32_DMA_CR_xxx mode flags.
+ * \param dma_cb stm32_dmaisr_t: DMA interrupt callback.
+ * \param start bool: start the timer, else see bsp_adc_capture_start().
+ * \return bsp_status_t: BSP_ERROR if rate is too high for the sources.
+ *
+ */
+static bsp_status_t adc_timed_init(const bsp_dev_adc_t* sources, uint8_t nb_sources,
+				   uint32_t* sample_rate, uint16_t* samples,
+				   uint32_t nb_samples, uint32_t dma_mode,
+				   stm32_dmaisr_t dma_cb, bool start)
+{
+	ADC_HandleTypeDef* hadc;
+	TIM_HandleTypeDef htim;
+	TIM_MasterConfigTypeDef master_conf;
+	uint32_t seq_cycles, clock, period, prescaler;
+
+	if(adc_stream.active || (*sample_rate == 0) ||
+	   (nb_samples == 0) || (nb_samples > 0xffff))
+		return BSP_ERROR;
+
+	if(adc_scan_init(sources, nb_sources, BSP_ADC_STREAM_TRIG, &seq_cycles) != BSP_OK)
+		return BSP_ERROR;
+
+	/* ADCCLK = PCLK2 / 4 */
+	if(*sample_rate > (HAL_RCC_GetPCLK2Freq() / ADC_CLK_DIV) / seq_cycles)
+		return BSP_ERROR;
+
+	/* TIM3 is on APB1, timer clock is 2 x PCLK1 */
+	__TIM3_CLK_ENABLE();
+	clock = HAL_RCC_GetPCLK1Freq() * 2;
+	period = clock / *sample_rate;
+	prescaler = (period - 1) / 0x10000;
+	period = period / (prescaler + 1);
+	*sample_rate = clock / ((prescaler + 1) * period);
+
+	/*
+	 * Timer is configured before ADC and DMA are enabled: HAL_TIM_Base_Init()
+	 * generates an update event (UG) which is output on TRGO while MMS is
+	 * still in reset mode, and would otherwise store a spurious sample 0.
+	 */
+	htim.Instance = BSP_ADC_STREAM_TIMER;
+	htim.State = HAL_TIM_STATE_RESET;
+	htim.Init.Period = period - 1;
+	htim.Init.Prescaler = prescaler;
+	htim.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	htim.Init.CounterMode = TIM_COUNTERMODE_UP;
+	htim.Init.RepetitionCounter = 0;
+	master_conf.MasterOutputTrigger = TIM_TRGO_UPDATE;
+	master_conf.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+	if((HAL_TIM_Base_Init(&htim) != HAL_OK) ||
+	   (HAL_TIMEx_MasterConfigSynchronization(&htim, &master_conf) != HAL_OK)) {
+		adc_timer_deinit();
+		bsp_adc_deinit(BSP_DEV_ADC1);
+		return BSP_ERROR;
+	}
+	/* First trigger on the first timer clock after start */
+	BSP_ADC_STREAM_TIMER->CNT = period - 1;
+
+	adc_stream.dma = STM32_DMA_STREAM(BSP_ADC1_DMA_STREAM);
+	if(dmaStreamAllocate(adc_stream.dma, BSP_ADC1_DMA_IRQ_PRIORITY,
+			     dma_cb, NULL)) {
+		adc_timer_deinit();
+		bsp_adc_deinit(BSP_DEV_ADC1);
+		return BSP_ERROR;
+	}
+
+	chBSemObjectInit(&adc_stream.sem, true);
+	adc_stream.samples = samples;
+	adc_stream.size = nb_samples;
+	adc_stream.produced = 0;
+	adc_stream.consumed = 0;
+	adc_stream.drops = 0;
+
+	hadc = &adc_handle[BSP_DEV_ADC1];
+	dmaStreamSetPeripheral(adc_stream.dma, &hadc->Instance->DR);
+	dmaStreamSetMemory0(adc_stream.dma, samples);
+	dmaStreamSetTransactionSize(adc_stream.dma, nb_samples);
+	dmaStreamSetMode(adc_stream.dma,
+			 STM32_DMA_CR_CHSEL(BSP_ADC1_DMA_CHANNEL) |
+			 STM32_DMA_CR_PL(BSP_ADC1_DMA_PRIORITY) |
+			 STM32_DMA_CR_DIR_P2M | STM32_DMA_CR_MINC |
+			 STM32_DMA_CR_PSIZE_HWORD | STM32_DMA_CR_MSIZE_HWORD |
+			 dma_mode);
+	dmaStreamEnable(adc_stream.dma);
+
+	hadc->Instance->CR2 |= ADC_CR2_DMA;
+	__HAL_ADC_ENABLE(hadc);
+	/* ADC stabilization time */
+	DelayUs(3);
+
+	adc_stream.active = true;
+	if(start)
+		__HAL_TIM_ENABLE(&htim);
+
+	return BSP_OK;
+}
+
+/** \brief Start timer triggered acquisition of a sources sequence to a DMA
+ * double buffer.
+ *
+ * \param sources const bsp_dev_adc_t*: sources converted at each trigger.
+ * \param nb_sources uint8_t: number of sources.
+ * \param sample_rate uint32_t*: sequences per second, set to the real rate.
+ * \param samples uint16_t*: DMA buffer (not in CCM).
+ * \param nb_samples uint32_t: DMA buffer size in samples (max 65535).
+ * \return bsp_status_t: BSP_ERROR if rate is too high for the sources.
+ *
+ * Each half buffer starts with first source, samples are 12bits right
+ * aligned in 16bits.
+ *
+ */
+bsp_status_t bsp_adc_stream_start(const bsp_dev_adc_t* sources, uint8_t nb_sources,
+				  uint32_t* sample_rate, uint16_t* samples, uint32_t nb_samples)
+{
+	if(nb_sources == 0)
+		return BSP_ERROR;
+
+	adc_stream.half_size = (nb_samples / 2) - ((nb_samples / 2) % nb_sources);
+
+	return adc_timed_init(sources, nb_sources, sample_rate, samples,
+			      adc_stream.half_size * 2,
+			      STM32_DMA_CR_CIRC | STM32_DMA_CR_HTIE | STM32_DMA_CR_TCIE,
+			      adc_stream_dma_cb, true);
+}
+
+/** \brief Get next filled half buffer.
+ *
+ * \param samples uint16_t**: set to the first sample of the half buffer.
+ * \param timeout uint32_t: max time to wait (in ticks).
+ * \return uint32_t: number of samples (0 on timeout).
+ *
+ * The half buffer shall be processed before DMA fills the other half,
+ * skipped half buffers are counted by bsp_adc_stream_drops().
+ *
+ */
+uint32_t bsp_adc_stream_read(uint16_t** samples, uint32_t timeout)
+{
+	uint32_t lag;
+
+	if(!adc_stream.active)
+		return 0;
+
+	if(adc_stream.produced == adc_stream.consumed) {
+		chBSemWaitTimeout(&adc_stream.sem, timeout);
+		if(adc_stream.produced == adc_stream.consumed)
+			return 0;
+	}
+
+	lag = adc_stream.produced - adc_stream.consumed;
+	if(lag > 1) {
+		/* Only the last filled half is still valid */
+		adc_stream.drops += (lag - 1) * adc_stream.half_size;
+		adc_stream.consumed += lag - 1;
+	}
+
+	*samples = &adc_stream.samples[(adc_stream.consumed & 1) * adc_stream.half_size];
+	adc_stream.consumed++;
+
+	return adc_stream.half_size;
+}
+
+/** \brief Number of samples lost since bsp_adc_stream_start().
+ *
+ * \return uint32_t: samples overwritten by DMA before being read.
+ *
+ */
+uint32_t bsp_adc_stream_drops(void)
+{
+	return adc_stream.drops;
+}
+
+/** \brief Stop timer triggered acquisition.
+ *
+ * \return bsp_status_t: status of the stop.
+ *
+ */
+bsp_status_t bsp_adc_stream_stop(void)
+{
+	if(!adc_stream.active)
+		return BSP_OK;
+
+	adc_timer_deinit();
+
+	dmaStreamDisable(adc_stream.dma);
+	dmaStreamRelease(adc_stream.dma);
+	adc_stream.active = false;
+
+	return bsp_adc_deinit(BSP_DEV_ADC1);
+}
+
+static void adc_capture_dma_cb(void* p, uint32_t flags)
+{
+	(void)p;
+	(void)flags;
+
+	chSysLockFromISR();
+	chBSemSignalI(&adc_stream.sem);
+	chSysUnlockFromISR();
+}
+
+/** \brief Prepare a one shot acquisition window started by
+ * bsp_adc_capture_start().
+ *
+ * \param source bsp_dev_adc_t: source to capture.
+ * \param sample_rate uint32_t*: samples per second, set to the real rate.
+ * \param samples uint16_t*: DMA buffer (not in CCM).
+ * \param nb_samples uint32_t: window size in samples (max 65535).
+ * \return bsp_status_t: status of the configuration.
+ *
+ */
+bsp_status_t bsp_adc_capture_arm(bsp_dev_adc_t source, uint32_t* sample_rate,
+				 uint16_t* samples, uint32_t nb_samples)
+{
+	return adc_timed_init(&source, 1, sample_rate, samples, nb_samples,
+			      STM32_DMA_CR_TCIE, adc_capture_dma_cb, false);
+}
+
+/** \brief Start the armed acquisition window.
+ *
+ * Only enables the trigger timer, to be called just before the first bus
+ * access of the traced operation.
+ *
+ */
+void bsp_adc_capture_start(void)
+{
+	if(adc_stream.active)
+		BSP_ADC_STREAM_TIMER->CR1 |= TIM_CR1_CEN;
+}
+
+/** \brief Wait end of the acquisition window and stop it.
+ *
+ * \param timeout uint32_t: max time to wait for a full window (in ticks).
+ * \return uint32_t: number of samples captured.
+ *
+ */
+uint32_t bsp_adc_capture_stop(uint32_t timeout)
+{
+	uint32_t nb;
+
+	if(!adc_stream.active)
+		return 0;
+
+	chBSemWaitTimeout(&adc_stream.sem, timeout);
+	BSP_ADC_STREAM_TIMER->CR1 &= ~TIM_CR1_CEN;
+	nb = adc_stream.size - dmaStreamGetTransactionSize(adc_stream.dma);
+	bsp_adc_stream_stop();
+
+	return nb;
+}
@@ -32,4 +32,15 @@ bsp_status_t bsp_adc_deinit(bsp_dev_adc_t dev_num);
 bsp_status_t bsp_adc_read_u16(bsp_dev_adc_t dev_num, uint16_t* rx_data, uint8_t nb_data);
 bsp_status_t bsp_adc_trigger(uint32_t low, uint32_t high, uint32_t delay);
 
+bsp_status_t bsp_adc_stream_start(const bsp_dev_adc_t* sources, uint8_t nb_sources,
+				  uint32_t* sample_rate, uint16_t* samples, uint32_t nb_samples);
+uint32_t bsp_adc_stream_read(uint16_t** samples, uint32_t timeout);
+uint32_t bsp_adc_stream_drops(void);
+bsp_status_t bsp_adc_stream_stop(void);
+
+bsp_status_t bsp_adc_capture_arm(bsp_dev_adc_t source, uint32_t* sample_rate,
+				 uint16_t* samples, uint32_t nb_samples);
+void bsp_adc_capture_start(void);
+uint32_t bsp_adc_capture_stop(uint32_t timeout);
+
 #endif /* _BSP_ADC_H_ */
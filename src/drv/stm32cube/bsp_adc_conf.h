@@ -23,6 +23,14 @@ limitations under the License.
 #define BSP_ADC1_PORT         GPIOA
 #define BSP_ADC1_PIN          GPIO_PIN_1 /* PA.1 */
 
+/* ADC1 DMA and timer used by bsp_adc_stream_xxx() */
+#define BSP_ADC1_DMA_STREAM       STM32_DMA_STREAM_ID(2, 4)
+#define BSP_ADC1_DMA_CHANNEL      0
+#define BSP_ADC1_DMA_PRIORITY     2 /* 0=Low to 3=Very high */
+#define BSP_ADC1_DMA_IRQ_PRIORITY 12
+#define BSP_ADC_STREAM_TIMER      TIM3 /* TRGO triggers ADC1 regular group */
+#define BSP_ADC_STREAM_TRIG       ADC_EXTERNALTRIGCONV_T3_TRGO
+
 #if 0
 /* ADC2 */
 #define BSP_ADC2              ADC_CHANNEL_6
@@ -7,14 +7,14 @@ STM32CUBESRC = ./drv/stm32cube/bsp.c \
                ./drv/stm32cube/bsp_tim.c \
                ./drv/stm32cube/bsp_rng.c \
                ./drv/stm32cube/bsp_fault_handler.c \
-               ./drv/stm32cube/bsp_print_dbg.c
+               ./drv/stm32cube/bsp_print_dbg.c \
+               ./drv/stm32cube/bsp_adc.c
 
 #               ./drv/stm32cube/bsp_smartcard.c \
 #               ./drv/stm32cube/bsp_can.c \
 #               ./drv/stm32cube/bsp_freq.c \
 #               ./drv/stm32cube/bsp_i2c_master.c \
 #               ./drv/stm32cube/bsp_i2c_slave.c \
-#               ./drv/stm32cube/bsp_adc.c \
 #               ./drv/stm32cube/bsp_dac.c \
 #               ./drv/stm32cube/bsp_pwm.c \
 
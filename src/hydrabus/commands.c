@@ -197,6 +197,7 @@ t_token_dict tl_dict[] = {
 	{ T_PRESCALER, "prescaler" },
 	{ T_CONVENTION, "convention" },
 	{ T_DELAY, "delay" },
+	{ T_PROFILE, "profile" },
 	/* Developer warning add new command(s) here */
 
 	/* BP-compatible commands */
@@ -352,6 +353,10 @@ t_token tokens_mode_nfc_show[] = {
 		T_REGISTERS,
 		.help = "Show NFC registers"
 	},
+	{
+		T_PROFILE,
+		.help = "Show and reset SPI traffic and time per NFC operation"
+	},
 	{ }
 };
 
@@ -188,6 +188,7 @@ enum {
 	T_PRESCALER,
 	T_CONVENTION,
 	T_DELAY,
+	T_PROFILE,
 	/* Developer warning add new command(s) here */
 
 	/* BP-compatible commands */
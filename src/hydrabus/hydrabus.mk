@@ -10,7 +10,8 @@ HYDRABUSSRC = hydrabus/hydrabus.c \
             hydrabus/hydrabus_bbio_spi.c \
             hydrabus/hydrabus_bbio_pin.c \
             hydrabus/hydrabus_bbio_aux.c \
-            hydrabus/hydrabus_sump.c
+            hydrabus/hydrabus_sump.c \
+            hydrabus/hydrabus_bbio_adc.c
 
 #            hydrabus/hydrabus_bbio_can.c \
 #            hydrabus/hydrabus_bbio_uart.c \
@@ -19,7 +20,6 @@ HYDRABUSSRC = hydrabus/hydrabus.c \
 #            hydrabus/hydrabus_bbio_rawwire.c \
 #            hydrabus/hydrabus_bbio_onewire.c \
 #            hydrabus/hydrabus_bbio_flash.c \
-#            hydrabus/hydrabus_bbio_adc.c \
 #            hydrabus/hydrabus_bbio_freq.c \
 
 #            hydrabus/hydrabus_mode_onewire.c \
@@ -117,13 +117,16 @@ int cmd_bbio(t_hydra_console *con)
 				/* Needed for flashrom detection */
 				cprint(con, "Hydrabus\r\n", 10);
 				return TRUE;
-/*
 			case BBIO_VOLT:
 				bbio_adc(con);
 				continue;
 			case BBIO_VOLT_CONT:
 				bbio_adc_continuous(con);
 				continue;
+			case BBIO_VOLT_STREAM:
+				bbio_adc_stream(con);
+				continue;
+/*
 			case BBIO_FREQ:
 				bbio_freq(con);
 				continue;
@@ -49,6 +49,7 @@
 #define BBIO_VOLT_CONT	0b00010101
 #define BBIO_FREQ	0b00010110
 #define BBIO_NFC_V2_CARD_EMULATOR	0b00010111
+#define BBIO_VOLT_STREAM	0b00011000
 
 /*
  * SPI-specific commands
@@ -57,6 +58,7 @@
 #define BBIO_SPI_CS_HIGH	0b00000011
 #define BBIO_SPI_WRITE_READ	0b00000100
 #define BBIO_SPI_WRITE_READ_NCS	0b00000101
+#define BBIO_SPI_WRITE_READ_TRACE	0b00000111
 #define BBIO_SPI_SNIFF_ALL	0b00001101
 #define BBIO_SPI_SNIFF_CS_LOW	0b00001110
 #define BBIO_SPI_SNIFF_CS_HIGH	0b00001111
@@ -22,6 +22,22 @@
 #include "hydrabus_bbio.h"
 #include "bsp_adc.h"
 
+/* Default rate of BBIO_VOLT_CONT */
+#define ADC_CONT_RATE (10000)
+/* Max number of DMA buffer samples, stored in g_sbuf */
+#define ADC_STREAM_BUFF_SIZE (16384)
+/* Half buffer duration, smaller at low rates to keep latency low */
+#define ADC_STREAM_BLOCK_PER_S (100)
+#define ADC_STREAM_TIMEOUT_MS (100)
+/* Max wait for a trace window after the end of the traced operation */
+#define ADC_TRACE_TIMEOUT_MS (1000)
+
+static struct {
+	uint16_t *samples;
+	uint32_t rate;
+	uint32_t nb_samples;
+} adc_trace;
+
 void bbio_adc(t_hydra_console *con)
 {
 	uint16_t value;
@@ -33,17 +49,159 @@ void bbio_adc(t_hydra_console *con)
 	bsp_adc_deinit(BSP_DEV_ADC1);
 }
 
+/* DMA buffer size giving about ADC_STREAM_BLOCK_PER_S half buffers per second */
+static uint32_t adc_stream_buff_size(uint32_t rate, uint8_t nb_sources)
+{
+	uint32_t half;
+
+	half = (rate * nb_sources) / ADC_STREAM_BLOCK_PER_S;
+	if(half < nb_sources)
+		half = nb_sources;
+	if(half > ADC_STREAM_BUFF_SIZE / 2)
+		half = ADC_STREAM_BUFF_SIZE / 2;
+	return half * 2;
+}
+
+/* Sends ADC1 samples as uint16_t big endian until BBIO_RESET is received */
 void bbio_adc_continuous(t_hydra_console *con)
 {
-	uint16_t value;
+	const bsp_dev_adc_t source = BSP_DEV_ADC1;
+	uint16_t *samples = (uint16_t *)g_sbuf;
+	uint8_t *out = g_sbuf + (ADC_STREAM_BUFF_SIZE * 2);
+	uint32_t rate = ADC_CONT_RATE;
+	uint32_t i, nb;
 	uint8_t cmd=1;
 
-	bsp_adc_init(BSP_DEV_ADC1);
+	if(bsp_adc_stream_start(&source, 1, &rate, samples,
+				adc_stream_buff_size(rate, 1)) != BSP_OK)
+		return;
+
 	while(cmd != BBIO_RESET) {
 		chnReadTimeout(con->sdu, &cmd, 1, TIME_IMMEDIATE);
-		bsp_adc_read_u16(BSP_DEV_ADC1, &value, 1);
-		cprintf(con, "%c", value>>8);
-		cprintf(con, "%c", value&0xff);
+		nb = bsp_adc_stream_read(&samples, TIME_MS2I(ADC_STREAM_TIMEOUT_MS));
+		for(i = 0; i < nb; i++) {
+			out[i*2] = samples[i] >> 8;
+			out[(i*2)+1] = samples[i] & 0xff;
+		}
+		cprint(con, (char *)out, nb * 2);
 	}
-	bsp_adc_deinit(BSP_DEV_ADC1);
+	bsp_adc_stream_stop();
+}
+
+/*
+ * Timer paced acquisition of the sources selected in a mask, until any byte
+ * is received.
+ * Parameters: rate (uint32_t big endian, sequences per second), sources mask
+ * (uint8_t, bit0 ADC1, bit1 temperature, bit2 Vrefint, bit3 Vbat).
+ * Answer: 0x01 and real rate (uint32_t big endian) or 0x00.
+ * Then blocks (little endian) of:
+ * - uint16_t number of samples (0 for the last block)
+ * - uint32_t total number of dropped samples
+ * - samples packed by two in three bytes: s0[7:0], s1[3:0]<<4 | s0[11:8],
+ *   s1[11:4], sources interleaved in the mask bit order.
+ */
+void bbio_adc_stream(t_hydra_console *con)
+{
+	bsp_dev_adc_t sources[BSP_DEV_ADC_END];
+	uint16_t *samples = (uint16_t *)g_sbuf;
+	uint8_t *out = g_sbuf + (ADC_STREAM_BUFF_SIZE * 2);
+	uint8_t rx_buff[5];
+	uint8_t nb_sources = 0;
+	uint32_t rate, drops, i, j, nb;
+	uint16_t s0, s1;
+
+	chnRead(con->sdu, rx_buff, 5);
+	rate = (rx_buff[0] << 24) | (rx_buff[1] << 16) |
+	       (rx_buff[2] << 8) | rx_buff[3];
+	for(i = 0; i < BSP_DEV_ADC_END; i++) {
+		if(rx_buff[4] & (1 << i))
+			sources[nb_sources++] = i;
+	}
+
+	if((nb_sources == 0) ||
+	   (bsp_adc_stream_start(sources, nb_sources, &rate, samples,
+				 adc_stream_buff_size(rate, nb_sources)) != BSP_OK)) {
+		cprint(con, "\x00", 1);
+		return;
+	}
+
+	out[0] = 1;
+	out[1] = rate >> 24;
+	out[2] = rate >> 16;
+	out[3] = rate >> 8;
+	out[4] = rate & 0xff;
+	cprint(con, (char *)out, 5);
+
+	do {
+		nb = bsp_adc_stream_read(&samples, TIME_MS2I(ADC_STREAM_TIMEOUT_MS));
+		if(nb == 0)
+			continue;
+
+		drops = bsp_adc_stream_drops();
+		out[0] = nb & 0xff;
+		out[1] = nb >> 8;
+		out[2] = drops & 0xff;
+		out[3] = (drops >> 8) & 0xff;
+		out[4] = (drops >> 16) & 0xff;
+		out[5] = drops >> 24;
+		j = 6;
+		for(i = 0; i < nb; i += 2) {
+			s0 = samples[i];
+			s1 = (i + 1 < nb) ? samples[i + 1] : 0;
+			out[j++] = s0 & 0xff;
+			out[j++] = (s0 >> 8) | ((s1 & 0x0f) << 4);
+			out[j++] = s1 >> 4;
+		}
+		cprint(con, (char *)out, j);
+	} while(chnReadTimeout(con->sdu, rx_buff, 1, TIME_IMMEDIATE) == 0);
+
+	drops = bsp_adc_stream_drops();
+	bsp_adc_stream_stop();
+
+	out[0] = 0;
+	out[1] = 0;
+	out[2] = drops & 0xff;
+	out[3] = (drops >> 8) & 0xff;
+	out[4] = (drops >> 16) & 0xff;
+	out[5] = drops >> 24;
+	cprint(con, (char *)out, 6);
+}
+
+/*
+ * Arm a capture of ADC1 started by bsp_adc_capture_start() at the beginning
+ * of a bus operation, params are BBIO_ADC_TRACE_PARAMS_SIZE bytes.
+ */
+bool bbio_adc_trace_arm(const uint8_t *params, uint16_t *samples, uint32_t max_samples)
+{
+	adc_trace.samples = samples;
+	adc_trace.rate = (params[0] << 24) | (params[1] << 16) |
+			 (params[2] << 8) | params[3];
+	adc_trace.nb_samples = (params[4] << 8) | params[5];
+
+	if((adc_trace.nb_samples == 0) || (adc_trace.nb_samples > max_samples))
+		return false;
+
+	return bsp_adc_capture_arm(BSP_DEV_ADC1, &adc_trace.rate, samples,
+				   adc_trace.nb_samples) == BSP_OK;
+}
+
+/*
+ * Wait end of the trace window and send it after the operation answer:
+ * rate (uint32_t big endian), number of samples (uint16_t big endian)
+ * and samples (uint16_t little endian).
+ */
+void bbio_adc_trace_send(t_hydra_console *con)
+{
+	uint8_t header[6];
+	uint32_t nb;
+
+	nb = bsp_adc_capture_stop(TIME_MS2I(ADC_TRACE_TIMEOUT_MS));
+	header[0] = adc_trace.rate >> 24;
+	header[1] = adc_trace.rate >> 16;
+	header[2] = adc_trace.rate >> 8;
+	header[3] = adc_trace.rate & 0xff;
+	header[4] = nb >> 8;
+	header[5] = nb & 0xff;
+	cprint(con, (char *)header, 6);
+	cprint(con, (char *)adc_trace.samples, nb * 2);
 }
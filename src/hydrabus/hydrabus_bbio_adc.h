@@ -19,3 +19,9 @@
 
 void bbio_adc(t_hydra_console *con);
 void bbio_adc_continuous(t_hydra_console *con);
+void bbio_adc_stream(t_hydra_console *con);
+
+/* Trace parameters: rate (uint32_t big endian), samples (uint16_t big endian) */
+#define BBIO_ADC_TRACE_PARAMS_SIZE (6)
+bool bbio_adc_trace_arm(const uint8_t *params, uint16_t *samples, uint32_t max_samples);
+void bbio_adc_trace_send(t_hydra_console *con);
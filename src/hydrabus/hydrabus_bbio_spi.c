@@ -27,6 +27,8 @@
 #include "hydrabus_bbio_spi.h"
 #include "bsp_spi.h"
 #include "hydrabus_bbio_aux.h"
+#include "hydrabus_bbio_adc.h"
+#include "bsp_adc.h"
 
 void bbio_spi_init_proto_default(t_hydra_console *con)
 {
@@ -98,6 +100,9 @@ void bbio_mode_spi(t_hydra_console *con)
 	uint32_t to_rx, to_tx, i;
 	uint8_t *tx_data = (uint8_t *)g_sbuf;
 	uint8_t *rx_data = (uint8_t *)g_sbuf+4096;
+	uint16_t *trace = (uint16_t *)(g_sbuf+8192);
+	uint8_t trace_params[BBIO_ADC_TRACE_PARAMS_SIZE];
+	bool traced;
 	uint8_t data;
 	bsp_status_t status;
 	mode_config_proto_t* proto = &con->mode->proto;
@@ -131,6 +136,12 @@ void bbio_mode_spi(t_hydra_console *con)
 				break;
 			case BBIO_SPI_WRITE_READ:
 			case BBIO_SPI_WRITE_READ_NCS:
+			case BBIO_SPI_WRITE_READ_TRACE:
+				traced = (bbio_subcommand == BBIO_SPI_WRITE_READ_TRACE);
+				if(traced) {
+					chnRead(con->sdu, trace_params,
+						BBIO_ADC_TRACE_PARAMS_SIZE);
+				}
 				chnRead(con->sdu, rx_data, 4);
 				to_tx = (rx_data[0] << 8) + rx_data[1];
 				to_rx = (rx_data[2] << 8) + rx_data[3];
@@ -138,11 +149,27 @@ void bbio_mode_spi(t_hydra_console *con)
 					cprint(con, "\x00", 1);
 					break;
 				}
-				if(bbio_subcommand == BBIO_SPI_WRITE_READ) {
+				if(traced) {
+					/* Data is read first to keep USB out of the window */
+					if(to_tx > 0) {
+						chnRead(con->sdu, tx_data, to_tx);
+					}
+					if(!bbio_adc_trace_arm(trace_params, trace,
+							       (NB_SBUFFER-8192)/2)) {
+						cprint(con, "\x00", 1);
+						break;
+					}
+				}
+				if(bbio_subcommand != BBIO_SPI_WRITE_READ_NCS) {
 					bsp_spi_select(proto->dev_num);
 				}
+				if(traced) {
+					bsp_adc_capture_start();
+				}
 				if(to_tx > 0) {
-					chnRead(con->sdu, tx_data, to_tx);
+					if(!traced) {
+						chnRead(con->sdu, tx_data, to_tx);
+					}
 					i=0;
 					while(i<to_tx) {
 						if((to_tx-i) >= 255) {
@@ -170,11 +197,14 @@ void bbio_mode_spi(t_hydra_console *con)
 					}
 					i+=255;
 				}
-				if(bbio_subcommand == BBIO_SPI_WRITE_READ) {
+				if(bbio_subcommand != BBIO_SPI_WRITE_READ_NCS) {
 					bsp_spi_unselect(proto->dev_num);
 				}
 				cprint(con, "\x01", 1);
 				cprint(con, (char *)rx_data, to_rx);
+				if(traced) {
+					bbio_adc_trace_send(con);
+				}
 				break;
 			case BBIO_SPI_AVR:
 				cprint(con, "\x01", 1);
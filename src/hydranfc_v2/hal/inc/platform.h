@@ -42,6 +42,12 @@
 #include "timer.h"
 
 void DelayMs(uint32_t delay_ms);
+void hydranfc_v2_protect_comm(void);
+void hydranfc_v2_unprotect_comm(void);
+void hydranfc_v2_protect_irq_status(void);
+void hydranfc_v2_unprotect_irq_status(void);
+void hydranfc_v2_protect_worker(void);
+void hydranfc_v2_unprotect_worker(void);
 void rfalPreTransceiveCb(void);
 
 /* USER CODE END Private defines */
@@ -65,7 +71,7 @@ void _Error_Handler(char *, int);
 
 #define ST25R391X_SPI_DEVICE	BSP_DEV_SPI2
 
-#define ST25R_COM_SINGLETXRX /*!< Use single Transceive */
+/* ST25R_COM_SINGLETXRX not defined, hal_st25r3916_spiTxRx() works on caller buffers directly */
 #define ST25R_SS_PIN            GPIO_PIN_1 /*!< GPIO pin used for ST25R SPI SS */ 
 #define ST25R_SS_PORT           GPIOC /*!< GPIO port used for ST25R SPI SS port */                
 #define ST25R_INT_PIN           GPIO_PIN_1 /*!< GPIO pin used for ST25R External Interrupt */
@@ -97,12 +103,15 @@ void _Error_Handler(char *, int);
 #define HAL_GetTick() ( HAL_GetTickMs() )
 #define _Error_Handler(__FILE__, __LINE__) // Ignore errors
 
-/* Protect ST25RComm from EXTI1_IRQ used with PA1 & ST25R3916 IRQ to avoid ST25R3916 IRQ to preempt spi transfer in user code */
-#define platformProtectST25RComm()         do{ globalCommProtectCnt++; __DSB();NVIC_DisableIRQ(EXTI1_IRQn);__DSB();__ISB();}while(0) /*!< Protect unique access to ST25R391x communication channel - IRQ disable on single thread environment (MCU) ; Mutex lock on a multi thread environment      */
-#define platformUnprotectST25RComm()       do{ if (--globalCommProtectCnt==0) {NVIC_EnableIRQ(EXTI1_IRQn);} }while(0)                /*!< Unprotect unique access to ST25R391x communication channel - IRQ enable on a single thread environment (MCU) ; Mutex unlock on a multi thread environment */
+/* ST25R3916 IRQ (EXTI1_IRQ on PA1) is processed in a thread (see hydranfc_v2.c), so the com channel is protected with a mutex */
+#define platformProtectST25RComm()         hydranfc_v2_protect_comm()                       /*!< Protect unique access to ST25R391x communication channel - IRQ disable on single thread environment (MCU) ; Mutex lock on a multi thread environment      */
+#define platformUnprotectST25RComm()       hydranfc_v2_unprotect_comm()                     /*!< Unprotect unique access to ST25R391x communication channel - IRQ enable on a single thread environment (MCU) ; Mutex unlock on a multi thread environment */
 
-#define platformProtectST25RIrqStatus()    platformProtectST25RComm()                       /*!< Protect unique access to IRQ status var - IRQ disable on single thread environment (MCU) ; Mutex lock on a multi thread environment */
-#define platformUnprotectST25RIrqStatus()  platformUnprotectST25RComm()                     /*!< Unprotect the IRQ status var - IRQ enable on a single thread environment (MCU) ; Mutex unlock on a multi thread environment         */
+#define platformProtectST25RIrqStatus()    hydranfc_v2_protect_irq_status()                 /*!< Protect unique access to IRQ status var - IRQ disable on single thread environment (MCU) ; Mutex lock on a multi thread environment */
+#define platformUnprotectST25RIrqStatus()  hydranfc_v2_unprotect_irq_status()               /*!< Unprotect the IRQ status var - IRQ enable on a single thread environment (MCU) ; Mutex unlock on a multi thread environment         */
+
+#define platformProtectWorker()            hydranfc_v2_protect_worker()                     /*!< Protect RFAL Worker/Task/Process from concurrent execution on multi thread platforms */
+#define platformUnprotectWorker()          hydranfc_v2_unprotect_worker()                   /*!< Unprotect RFAL Worker/Task/Process from concurrent execution on multi thread platforms */
 
 
 #define platformLedOff( port, pin )        platformGpioClear((port), (pin))                 /*!< Turns the given LED Off */
@@ -118,8 +127,12 @@ void _Error_Handler(char *, int);
 #define platformTimerCreate( t)            timerCalculateTimer(t)                           /*!< Create a timer with the given time (ms) */
 #define platformTimerIsExpired(timer)      timerIsExpired(timer)                            /*!< Checks if the given timer is expired */
 #define platformDelay( t )                 HAL_Delay( t )                                   /*!< Performs a delay for the given time (ms) */
+#define platformTimerCreateUs( t )         timerCalculateTimerUs(t)                         /*!< Create a timer with the given time (us) */
+#define platformTimerCreate1fc( t )        timerCalculateTimerUs(rfalConv1fcToUs(t))        /*!< Create a timer with the given time (1/fc) */
+#define platformDelayUs( t )               timerDelayUs( t )                                /*!< Performs a delay for the given time (us) */
 
 #define platformGetSysTick()               HAL_GetTick()                                    /*!< Get System Tick (1 tick = 1 ms) */
+#define platformGetSysTickUs()             timerGetUs()                                     /*!< Get the timer time base (1 tick = 1 us) */
 
 #define platformAssert( exp )              assert_param( exp )                              /*!< Asserts whether the given expression is true */
 #define platformErrorHandle()              _Error_Handler(__FILE__, __LINE__)               /*!< Global error handle\trap */
@@ -127,6 +140,9 @@ void _Error_Handler(char *, int);
 #define platformSpiSelect()                platformGpioClear( ST25R_SS_PORT, ST25R_SS_PIN ) /*!< SPI SS\CS: Chip|Slave Select */
 #define platformSpiDeselect()              platformGpioSet( ST25R_SS_PORT, ST25R_SS_PIN )   /*!< SPI SS\CS: Chip|Slave Deselect */
 #define platformSpiTxRx(txBuf, rxBuf, len) hal_st25r3916_spiTxRx(txBuf, rxBuf, len)         /*!< SPI transceive */
+#define platformSpiTxRxStart(txBuf, rxBuf, len, cb) hal_st25r3916_spiTxRxStart(txBuf, rxBuf, len, cb, NULL) /*!< SPI transceive started in background */
+#define platformSpiTxRxWait()              hal_st25r3916_spiWait(ST25R_SPI_TIMEOUT)         /*!< Wait for the end of a background SPI transceive */
+#define ST25R_SPI_TIMEOUT                  1000U                                            /*!< About 0.1sec (see common/chconf.h/CH_CFG_ST_FREQUENCY) */
 
 /* I2C not used disabled */
 #if 0
@@ -149,7 +165,7 @@ void _Error_Handler(char *, int);
 * GLOBAL VARIABLES
 ******************************************************************************
 */
-extern uint8_t globalCommProtectCnt; /* Global Protection Counter provided per platform - instantiated in hydranfc_v2.c */
+extern uint8_t globalCommProtectCnt; /* Global Protection Counter provided per platform - instantiated in hydranfc_v2_nfc_mode.c, nesting count of the com mutex */
 
 /*
 ******************************************************************************
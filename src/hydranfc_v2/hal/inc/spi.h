@@ -41,6 +41,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include "platform.h"
 
+/*! Transfer completion callback, called from DMA ISR context */
+typedef void (*hal_st25r3916_spiCb_t)(void *param);
+
 /*!
  *****************************************************************************
  *  \brief  Initalize SPI
@@ -53,6 +56,16 @@
  */   
 void hal_st25r3916_spiInit(bsp_dev_spi_t dev_num);
 
+/*!
+ *****************************************************************************
+ *  \brief  Deinitalize SPI
+ * 
+ *  This function releases the DMA streams used for SPI transfers.
+ *
+ *****************************************************************************
+ */
+void hal_st25r3916_spiDeinit(void);
+
 /*!
  *****************************************************************************
  *  \brief  Set SPI CS line
@@ -87,6 +100,8 @@ void hal_st25r3916_spiDeselect(GPIO_TypeDef *ssPort, uint16_t ssPin);
  * 
  *  This funtion transmits first no of "length" bytes from "txData" and tries 
  *  then to receive "length" bytes.
+ *  Short transfers and buffers in CCM (not reachable by DMA) are polled,
+ *  the others use DMA directly on the caller buffers.
  * 
  *  \param[in] txData : pointer to buffer to be transmitted.
  *
@@ -94,11 +109,53 @@ void hal_st25r3916_spiDeselect(GPIO_TypeDef *ssPort, uint16_t ssPin);
  *
  *  \param[in] length : buffer length
  *
- *  \return : HAL error code
+ *  \return : HAL_TIMEOUT if the transfer did not end within SPI_TIMEOUT,
+ *            HAL error code otherwise
  *
  *****************************************************************************
  */
 HAL_StatusTypeDef hal_st25r3916_spiTxRx(const uint8_t *txData, uint8_t *rxData, uint16_t length);
+
+/*!
+ *****************************************************************************
+ *  \brief  Start a DMA Transmit Receive
+ * 
+ *  This function starts transferring "length" bytes from/to the caller
+ *  buffers and returns immediately. Buffers shall stay valid until the
+ *  transfer ends. NULL txData sends 0x00, NULL rxData discards data.
+ * 
+ *  \param[in] txData : pointer to buffer to be transmitted, or NULL
+ *
+ *  \param[out] rxData : pointer to buffer to be received, or NULL
+ *
+ *  \param[in] length : buffer length
+ *
+ *  \param[in] cb : optional function called when the transfer ends
+ *
+ *  \param[in] param : parameter given to cb
+ *
+ *  \return : HAL_BUSY if a transfer is ongoing, HAL_ERROR if DMA is not
+ *            available or a buffer is in CCM (not reachable by DMA)
+ *
+ *****************************************************************************
+ */
+HAL_StatusTypeDef hal_st25r3916_spiTxRxStart(const uint8_t *txData, uint8_t *rxData,
+		uint16_t length, hal_st25r3916_spiCb_t cb, void *param);
+
+/*!
+ *****************************************************************************
+ *  \brief  Wait for the end of a DMA Transmit Receive
+ * 
+ *  Returns immediately if no transfer is ongoing. Any thread can wait for
+ *  a transfer started by another one.
+ * 
+ *  \param[in] timeout : timeout in system ticks
+ *
+ *  \return : HAL_TIMEOUT if the transfer has been aborted
+ *
+ *****************************************************************************
+ */
+HAL_StatusTypeDef hal_st25r3916_spiWait(uint32_t timeout);
    
 #endif /*__spi_H */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
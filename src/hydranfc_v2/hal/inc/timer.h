@@ -28,7 +28,7 @@
  *
  *  \brief SW Timer implementation header file
  *   
- *   This module makes use of a System Tick in millisconds and provides
+ *   This module makes use of a microsecond time base and provides
  *   an abstraction for SW timers
  *
  */
@@ -73,6 +73,51 @@
 uint32_t timerCalculateTimer( uint16_t time );
 
 
+/*! 
+ *****************************************************************************
+ * \brief  Calculate Timer in Microseconds
+ *  
+ * Same as timerCalculateTimer() with the time given in microseconds
+ * 
+ * \param[in]  time : time/duration in Microseconds for the timer
+ *
+ * \return u32 : The new timer calculated based on the given time 
+ *****************************************************************************
+ */
+uint32_t timerCalculateTimerUs( uint32_t time );
+
+
+/*! 
+ *****************************************************************************
+ * \brief  Get Time in Microseconds
+ *  
+ * This method returns the microsecond time base used by the SW timers.
+ * It wraps around every 2^32 us (~71min)
+ * 
+ * \return The current time in Microseconds
+ *****************************************************************************
+ */
+uint32_t timerGetUs( void );
+
+
+/*! 
+ *****************************************************************************
+ * \brief  Get Next Timer Expiry
+ *  
+ * This method returns the time left until the earliest pending timer created
+ * with timerCalculateTimer()/timerCalculateTimerUs() expires, expired ones
+ * are dropped. Destroyed timers are not tracked, so it may report a deadline
+ * nobody waits for anymore.
+ * 
+ * \param[out] remaining : time in Microseconds until the next expiry
+ *
+ * \return true  : a timer is pending, remaining is set
+ * \return false : no timer is pending
+ *****************************************************************************
+ */
+bool timerGetNextExpiry( uint32_t *remaining );
+
+
 /*! 
  *****************************************************************************
  * \brief  Checks if a Timer is Expired
@@ -105,6 +150,20 @@ bool timerIsExpired( uint32_t timer );
 void timerDelay( uint16_t time );
 
 
+/*! 
+ *****************************************************************************
+ * \brief  Performs a Delay in Microseconds
+ *  
+ * This method performs a blocking delay for the given amount of time in
+ * Microseconds
+ * 
+ * \param[in]  time : time/duration in Microseconds of the delay
+ *
+ *****************************************************************************
+ */
+void timerDelayUs( uint32_t time );
+
+
 /*! 
  *****************************************************************************
  * \brief  Stopwatch start
@@ -126,3 +185,15 @@ void timerStopwatchStart( void );
  *****************************************************************************
  */
 uint32_t timerStopwatchMeasure( void );
+
+
+/*! 
+ *****************************************************************************
+ * \brief  Stopwatch Measure in Microseconds
+ *  
+ * This method returns the elapsed time in us since the stopwatch was initiated
+ * 
+ * \return The time in us since the stopwatch was started
+ *****************************************************************************
+ */
+uint32_t timerStopwatchMeasureUs( void );
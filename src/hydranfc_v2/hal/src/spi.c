@@ -38,19 +38,153 @@
 
 /* Includes ------------------------------------------------------------------*/
 
+#include "hal.h"
 #include "spi.h"
 #include "st_errno.h"
 #include "string.h"
 
 #define SPI_TIMEOUT   1000 // About 0.1sec (see common/chconf.h/CH_CFG_ST_FREQUENCY)
-#define SPI_BUF_LEN   512
-static uint8_t txBuf[SPI_BUF_LEN];
-static uint8_t rxBuf[SPI_BUF_LEN];
+
+/* Shorter transfers (register access) are faster polled than with DMA setup */
+#define SPI_DMA_MIN_LEN          8
+
+/* DMA2/DMA1 cannot access the CCM data RAM (0x10000000-0x1000FFFF) */
+#define SPI_DMA_REACHABLE(p)     (((uint32_t)(p) & 0xFFFF0000U) != 0x10000000U)
+
+/* SPI2 DMA streams, see RM0090 Table 42 */
+#define SPI_DMA_RX_STREAM        STM32_DMA_STREAM_ID(1, 3)
+#define SPI_DMA_TX_STREAM        STM32_DMA_STREAM_ID(1, 4)
+#define SPI_DMA_CHANNEL          0
+#define SPI_DMA_PRIORITY         3 /* 0=Low to 3=Very high */
+#define SPI_DMA_IRQ_PRIORITY     12
+
+typedef struct {
+	const stm32_dma_stream_t *rx_dma;
+	const stm32_dma_stream_t *tx_dma;
+	binary_semaphore_t done_sem;
+	hal_st25r3916_spiCb_t cb;
+	void *cb_param;
+	volatile bool busy;
+	bool active;
+} spi_dma_t;
+
+static spi_dma_t spiDma;
+/* Source of dummy bytes for reads and sink of ignored bytes for writes */
+static uint8_t spiDummyTx = 0x00;
+static uint8_t spiDummyRx;
 SPI_HandleTypeDef *pSpi = 0;
 
+static void spi_dma_rx_cb(void *p, uint32_t flags)
+{
+	spi_dma_t *sd = (spi_dma_t *)p;
+	hal_st25r3916_spiCb_t cb;
+
+	(void)flags;
+	/* Last byte received, transfer is over on both directions */
+	dmaStreamDisable(sd->rx_dma);
+	dmaStreamDisable(sd->tx_dma);
+	CLEAR_BIT(pSpi->Instance->CR2, SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+
+	cb = sd->cb;
+	sd->busy = false;
+	if (cb != NULL)
+	{
+		cb(sd->cb_param);
+	}
+
+	chSysLockFromISR();
+	chBSemSignalI(&sd->done_sem);
+	chSysUnlockFromISR();
+}
+
+static void spi_dma_abort(void)
+{
+	dmaStreamDisable(spiDma.rx_dma);
+	dmaStreamDisable(spiDma.tx_dma);
+	CLEAR_BIT(pSpi->Instance->CR2, SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+	spiDma.busy = false;
+}
+
+/* Wait for a SPI status flag, SPI_TIMEOUT ticks at most for the whole transfer */
+static HAL_StatusTypeDef spi_polled_wait(SPI_TypeDef *spi, uint32_t flag,
+		systime_t start)
+{
+	while ((spi->SR & flag) == 0)
+	{
+		if (chVTTimeElapsedSinceX(start) >= (sysinterval_t)SPI_TIMEOUT)
+		{
+			return HAL_TIMEOUT;
+		}
+	}
+	return HAL_OK;
+}
+
+/* Byte per byte transfer without copy, NULL buffers use dummy bytes */
+static HAL_StatusTypeDef spi_polled_txrx(const uint8_t *txData, uint8_t *rxData,
+		uint16_t length)
+{
+	SPI_TypeDef *spi = pSpi->Instance;
+	systime_t start = chVTGetSystemTimeX();
+	uint8_t data;
+	uint16_t i;
+
+	__HAL_SPI_ENABLE(pSpi);
+	for (i = 0; i < length; i++)
+	{
+		if (spi_polled_wait(spi, SPI_SR_TXE, start) != HAL_OK)
+		{
+			return HAL_TIMEOUT;
+		}
+		spi->DR = (txData != NULL) ? txData[i] : spiDummyTx;
+		if (spi_polled_wait(spi, SPI_SR_RXNE, start) != HAL_OK)
+		{
+			return HAL_TIMEOUT;
+		}
+		data = spi->DR;
+		if (rxData != NULL)
+		{
+			rxData[i] = data;
+		}
+	}
+	return HAL_OK;
+}
+
 void hal_st25r3916_spiInit(bsp_dev_spi_t dev_num)
 {
 	pSpi = bsp_spi_get_handle(dev_num);
+
+	if (spiDma.active)
+	{
+		return;
+	}
+	spiDma.rx_dma = STM32_DMA_STREAM(SPI_DMA_RX_STREAM);
+	spiDma.tx_dma = STM32_DMA_STREAM(SPI_DMA_TX_STREAM);
+	/* Stay on polled transfers if DMA streams are used by another mode */
+	if (dmaStreamAllocate(spiDma.rx_dma, SPI_DMA_IRQ_PRIORITY,
+			      spi_dma_rx_cb, &spiDma))
+	{
+		return;
+	}
+	if (dmaStreamAllocate(spiDma.tx_dma, SPI_DMA_IRQ_PRIORITY, NULL, NULL))
+	{
+		dmaStreamRelease(spiDma.rx_dma);
+		return;
+	}
+	chBSemObjectInit(&spiDma.done_sem, true);
+	spiDma.busy = false;
+	spiDma.active = true;
+}
+
+void hal_st25r3916_spiDeinit(void)
+{
+	if (spiDma.active)
+	{
+		spi_dma_abort();
+		dmaStreamRelease(spiDma.rx_dma);
+		dmaStreamRelease(spiDma.tx_dma);
+		spiDma.active = false;
+	}
+	pSpi = 0;
 }
 
 void hal_st25r3916_spiSelect(GPIO_TypeDef *ssPort, uint16_t ssPin)
@@ -63,29 +197,95 @@ void hal_st25r3916_spiDeselect(GPIO_TypeDef *ssPort, uint16_t ssPin)
 	HAL_GPIO_WritePin(ssPort, ssPin, GPIO_PIN_SET);
 }
 
-HAL_StatusTypeDef hal_st25r3916_spiTxRx(const uint8_t *txData, uint8_t *rxData,
-		uint16_t length)
+HAL_StatusTypeDef hal_st25r3916_spiTxRxStart(const uint8_t *txData, uint8_t *rxData,
+		uint16_t length, hal_st25r3916_spiCb_t cb, void *param)
 {
-	if (pSpi == 0)
-		return HAL_ERROR;
+	uint32_t mode;
 
-	if (length > SPI_BUF_LEN)
+	if ((pSpi == 0) || !spiDma.active || (length == 0))
 	{
 		return HAL_ERROR;
 	}
+	if (!SPI_DMA_REACHABLE(txData) || !SPI_DMA_REACHABLE(rxData))
+	{
+		return HAL_ERROR;
+	}
+	if (spiDma.busy)
+	{
+		return HAL_BUSY;
+	}
+	spiDma.busy = true;
+	spiDma.cb = cb;
+	spiDma.cb_param = param;
+	chBSemReset(&spiDma.done_sem, true);
+
+	/* Flush old character and overrun before starting */
+	(void)pSpi->Instance->DR;
+	(void)pSpi->Instance->SR;
+
+	mode = STM32_DMA_CR_CHSEL(SPI_DMA_CHANNEL) |
+	       STM32_DMA_CR_PL(SPI_DMA_PRIORITY);
+
+	dmaStreamSetPeripheral(spiDma.rx_dma, &pSpi->Instance->DR);
+	dmaStreamSetMemory0(spiDma.rx_dma, (rxData != NULL) ? rxData : &spiDummyRx);
+	dmaStreamSetTransactionSize(spiDma.rx_dma, length);
+	dmaStreamSetMode(spiDma.rx_dma, mode | STM32_DMA_CR_DIR_P2M |
+			 ((rxData != NULL) ? STM32_DMA_CR_MINC : 0) |
+			 STM32_DMA_CR_TCIE);
+
+	dmaStreamSetPeripheral(spiDma.tx_dma, &pSpi->Instance->DR);
+	dmaStreamSetMemory0(spiDma.tx_dma, (txData != NULL) ? txData : &spiDummyTx);
+	dmaStreamSetTransactionSize(spiDma.tx_dma, length);
+	dmaStreamSetMode(spiDma.tx_dma, mode | STM32_DMA_CR_DIR_M2P |
+			 ((txData != NULL) ? STM32_DMA_CR_MINC : 0));
 
-	/* Initialize Tx data*/
-	if (txData != NULL)
+	/* RX first so no byte is missed, TX request starts the clock */
+	dmaStreamEnable(spiDma.rx_dma);
+	dmaStreamEnable(spiDma.tx_dma);
+	__HAL_SPI_ENABLE(pSpi);
+	SET_BIT(pSpi->Instance->CR2, SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef hal_st25r3916_spiWait(uint32_t timeout)
+{
+	if (!spiDma.active || !spiDma.busy)
 	{
-		memcpy(txBuf, txData, length);
+		return HAL_OK;
 	}
-	else
+	if (chBSemWaitTimeout(&spiDma.done_sem, (sysinterval_t)timeout) != MSG_OK)
 	{
-		memset(txBuf, 0x00, length);
+		if (spiDma.busy)
+		{
+			spi_dma_abort();
+			return HAL_TIMEOUT;
+		}
 	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef hal_st25r3916_spiTxRx(const uint8_t *txData, uint8_t *rxData,
+		uint16_t length)
+{
+	HAL_StatusTypeDef status;
 
-	return HAL_SPI_TransmitReceive(pSpi, txBuf,
-			(rxData != NULL) ? rxData : rxBuf, length, SPI_TIMEOUT);
+	if (pSpi == 0)
+		return HAL_ERROR;
+
+	/* Caller buffers may be on a thread stack in CCM, out of DMA reach */
+	if ((length < SPI_DMA_MIN_LEN) || !spiDma.active ||
+	    !SPI_DMA_REACHABLE(txData) || !SPI_DMA_REACHABLE(rxData))
+	{
+		return spi_polled_txrx(txData, rxData, length);
+	}
+
+	status = hal_st25r3916_spiTxRxStart(txData, rxData, length, NULL, NULL);
+	if (status != HAL_OK)
+	{
+		return status;
+	}
+	return hal_st25r3916_spiWait(SPI_TIMEOUT);
 }
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -30,9 +30,14 @@
  *
  *  \author Gustavo Patricio
  *
- *   This module makes use of a System Tick in millisconds and provides
+ *   This module makes use of a microsecond time base and provides
  *   an abstraction for SW timers
  *
+ *   The time base accumulates the DWT cycle counter and is checked against
+ *   the ChibiOS system time, which also recovers it when the cycle counter
+ *   has been cleared (see wait_delay()) or not sampled for more than 2^32
+ *   cycles.
+ *
  */
 
 /*
@@ -41,12 +46,18 @@
 ******************************************************************************
 */
 #include "timer.h"
+#include "ch.h"
+#include "hal.h"
 
 /*
 ******************************************************************************
 * LOCAL DEFINES
 ******************************************************************************
 */
+#define TIMER_CYCLES_PER_US    (STM32_SYSCLK / 1000000U)           /*!< DWT cycles per microsecond            */
+#define TIMER_US_PER_TICK      (1000000U / CH_CFG_ST_FREQUENCY)     /*!< Microseconds per ChibiOS system tick  */
+#define TIMER_RESYNC_US        (2U * TIMER_US_PER_TICK)             /*!< Max drift before resync on system time */
+#define TIMER_DEADLINES_NB     16U                                  /*!< Deadlines tracked for timerGetNextExpiry() */
 
 /*
 ******************************************************************************
@@ -54,6 +65,44 @@
 ******************************************************************************
 */
 static uint32_t timerStopwatchTick;
+static uint32_t timerUs;       /*!< Microsecond time base                       */
+static uint32_t timerUsCyc;    /*!< DWT cycle counter at last update            */
+static uint32_t timerUsRem;    /*!< Cycles not yet accounted in timerUs         */
+static uint32_t timerDeadline[TIMER_DEADLINES_NB]; /*!< Deadlines of the created timers  */
+static uint8_t  timerDeadlineNb;                   /*!< Entries used in timerDeadline  */
+
+/*
+******************************************************************************
+* LOCAL FUNCTIONS
+******************************************************************************
+*/
+
+/*******************************************************************************/
+/* Drop the expired deadlines, return the index of the latest one (or the    *
+ * number of entries if none is left). Called with the system locked.        */
+static uint8_t timerDeadlinePrune( uint32_t now )
+{
+	uint8_t i;
+	uint8_t latest;
+
+	i      = 0;
+	latest = 0;
+	while( i < timerDeadlineNb )
+	{
+		if( (int32_t)(timerDeadline[i] - now) <= 0 )
+		{
+			timerDeadline[i] = timerDeadline[--timerDeadlineNb];
+			continue;
+		}
+		if( (int32_t)(timerDeadline[i] - timerDeadline[latest]) > 0 )
+		{
+			latest = i;
+		}
+		i++;
+	}
+
+	return ((timerDeadlineNb > 0U) ? latest : timerDeadlineNb);
+}
 
 /*
 ******************************************************************************
@@ -61,10 +110,98 @@ static uint32_t timerStopwatchTick;
 ******************************************************************************
 */
 
+/*******************************************************************************/
+uint32_t timerGetUs( void )
+{
+	syssts_t sts;
+	uint32_t cyc;
+	uint32_t sysUs;
+	uint32_t delta;
+
+	sts   = chSysGetStatusAndLockX();
+	cyc   = bsp_get_cyclecounter();
+	sysUs = ((uint32_t)chVTGetSystemTimeX() * TIMER_US_PER_TICK);
+
+	delta      = ((cyc - timerUsCyc) + timerUsRem);
+	timerUsCyc = cyc;
+	timerUs   += (delta / TIMER_CYCLES_PER_US);
+	timerUsRem = (delta % TIMER_CYCLES_PER_US);
+
+	/* The system time is the tick floor of the time base, anything outside *
+	 * [-TIMER_RESYNC_US, TIMER_RESYNC_US] means the DWT count was lost     */
+	if( (uint32_t)((timerUs - sysUs) + TIMER_RESYNC_US) > (2U * TIMER_RESYNC_US) )
+	{
+		timerUs    = sysUs;
+		timerUsRem = 0;
+	}
+	chSysRestoreStatusX(sts);
+
+	return timerUs;
+}
+
 /*******************************************************************************/
 uint32_t timerCalculateTimer( uint16_t time )
 {
-	return (platformGetSysTick() + time);
+	return timerCalculateTimerUs( (uint32_t)time * 1000U );
+}
+
+/*******************************************************************************/
+uint32_t timerCalculateTimerUs( uint32_t time )
+{
+	syssts_t sts;
+	uint32_t now;
+	uint32_t timer;
+	uint8_t  latest;
+
+	now   = timerGetUs();
+	timer = (now + time);
+
+	/* Track every pending deadline so that a sleeping worker wakes up for  *
+	 * each of them. When full, the latest one is forgotten: RFAL does not  *
+	 * run that many timers at once.                                        */
+	sts    = chSysGetStatusAndLockX();
+	latest = timerDeadlinePrune( now );
+	if( timerDeadlineNb < TIMER_DEADLINES_NB )
+	{
+		timerDeadline[timerDeadlineNb++] = timer;
+	}
+	else if( (int32_t)(timer - timerDeadline[latest]) < 0 )
+	{
+		timerDeadline[latest] = timer;
+	}
+	chSysRestoreStatusX(sts);
+
+	return timer;
+}
+
+/*******************************************************************************/
+bool timerGetNextExpiry( uint32_t *remaining )
+{
+	syssts_t sts;
+	uint32_t now;
+	uint32_t next;
+	uint8_t  i;
+	bool     ret;
+
+	now = timerGetUs();
+	sts = chSysGetStatusAndLockX();
+	(void)timerDeadlinePrune( now );
+	ret = (timerDeadlineNb > 0U);
+	if( ret )
+	{
+		next = timerDeadline[0];
+		for( i = 1; i < timerDeadlineNb; i++ )
+		{
+			if( (int32_t)(timerDeadline[i] - next) < 0 )
+			{
+				next = timerDeadline[i];
+			}
+		}
+		*remaining = (next - now);
+	}
+	chSysRestoreStatusX(sts);
+
+	return ret;
 }
 
 /*******************************************************************************/
@@ -73,10 +210,10 @@ bool timerIsExpired( uint32_t timer )
 	uint32_t uDiff;
 	int32_t sDiff;
 	
-	uDiff = (timer - platformGetSysTick());   /* Calculate the diff between the timers */
+	uDiff = (timer - timerGetUs());           /* Calculate the diff between the timers */
 	sDiff = uDiff;                            /* Convert the diff to a signed var      */
 	/* Having done this has two side effects: 
-	 * 1) all differences smaller than -(2^31) ms (~25d) will become positive
+	 * 1) all differences smaller than -(2^31) us (~35min) will become positive
 	 *    Signaling not expired: acceptable!
 	 * 2) Time roll-over case will be handled correctly: super!
 	 */
@@ -100,14 +237,29 @@ void timerDelay( uint16_t tOut )
 	while( timerIsRunning(t) );
 }
 
+/*******************************************************************************/
+void timerDelayUs( uint32_t tOut )
+{
+	uint32_t t;
+	
+	t = timerCalculateTimerUs( tOut );
+	while( timerIsRunning(t) );
+}
+
 /*******************************************************************************/
 void timerStopwatchStart( void )
 {
-	timerStopwatchTick = platformGetSysTick();
+	timerStopwatchTick = timerGetUs();
 }
 
 /*******************************************************************************/
 uint32_t timerStopwatchMeasure( void )
 {
-	return (uint32_t)(platformGetSysTick() - timerStopwatchTick);
+	return (timerStopwatchMeasureUs() / 1000U);
+}
+
+/*******************************************************************************/
+uint32_t timerStopwatchMeasureUs( void )
+{
+	return (uint32_t)(timerGetUs() - timerStopwatchTick);
 }
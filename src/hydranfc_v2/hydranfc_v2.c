@@ -16,6 +16,8 @@
  * limitations under the License.
  */
 
+#include <string.h>
+
 #include "bsp_gpio.h"
 
 #include "rfal_analogConfig.h"
@@ -23,6 +25,7 @@
 #include "rfal_dpo.h"
 #include "rfal_chip.h"
 #include "st25r3916.h"
+#include "st25r3916_com.h"
 #include "st25r3916_irq.h"
 #include "st25r3916_aat.h"
 
@@ -34,6 +37,27 @@ static volatile int irq;
 */
 static void (*st25r3916_irq_fn)(void) = NULL;
 
+/* Worker sleeps at most this long without IRQ, to poll the user inputs */
+#define WORKER_IDLE_US		10000
+
+/* Deferred ST25R3916 IRQ processing, above the threads waiting for its status */
+#define IRQ_THREAD_PRIO		(NORMALPRIO + 1)
+
+static BSEMAPHORE_DECL(irq_sem, true);
+static THD_WORKING_AREA(wa_st25r3916_irq, 1024);
+static thread_t *irq_thread = NULL;
+
+static MUTEX_DECL(comm_mtx);
+static thread_t *comm_owner = NULL;
+static MUTEX_DECL(rfal_worker_mtx);
+
+static BSEMAPHORE_DECL(worker_sem, true);
+static volatile uint32_t worker_irq_cycles;
+static hydranfc_v2_worker_stats_t worker_stats;
+static thread_t *worker_thread = NULL;
+static hydranfc_v2_worker_fn_t worker_fn;
+static void *worker_arg;
+
 /* Do not Enable DPO to have maximum performances/range */
 //#define DPO_ENABLE true
 
@@ -56,14 +80,118 @@ void rfalPreTransceiveCb(void)
 static void extcb1(void *arg) {
 	(void) arg;
 
-	if (st25r3916_irq_fn != NULL)
-		st25r3916_irq_fn();
+	worker_irq_cycles = bsp_get_cyclecounter();
+	worker_stats.irqs++;
+
+	/* ST25R3916 registers are read by st25r3916_irq thread */
+	chSysLockFromISR();
+	chBSemSignalI(&irq_sem);
+	chSysUnlockFromISR();
 /*
 	irq_count++;
 	irq = 1;
 */
 }
 
+static THD_FUNCTION(st25r3916_irq, arg)
+{
+	(void)arg;
+	void (*fn)(void);
+
+	chRegSetThreadName("ST25R3916 IRQ");
+
+	while (!chThdShouldTerminateX()) {
+		chBSemWait(&irq_sem);
+		if (chThdShouldTerminateX()) {
+			break;
+		}
+
+		fn = st25r3916_irq_fn;
+		if (fn != NULL)
+			fn();
+
+		chBSemSignal(&worker_sem);
+	}
+}
+
+static void irq_thread_start(void)
+{
+	if (irq_thread != NULL) {
+		return;
+	}
+	chBSemReset(&irq_sem, true);
+	irq_thread = chThdCreateStatic(wa_st25r3916_irq, sizeof(wa_st25r3916_irq),
+				       IRQ_THREAD_PRIO, st25r3916_irq, NULL);
+}
+
+static void irq_thread_stop(void)
+{
+	if (irq_thread == NULL) {
+		return;
+	}
+	chThdTerminate(irq_thread);
+	chBSemSignal(&irq_sem);
+	chThdWait(irq_thread);
+	irq_thread = NULL;
+}
+
+/* Recursive lock of the ST25R3916 communication channel, see platformProtectST25RComm() */
+void hydranfc_v2_protect_comm(void)
+{
+	thread_t *self = chThdGetSelfX();
+
+	if (comm_owner != self) {
+		chMtxLock(&comm_mtx);
+		comm_owner = self;
+	}
+	globalCommProtectCnt++;
+}
+
+void hydranfc_v2_unprotect_comm(void)
+{
+	if (--globalCommProtectCnt == 0) {
+		comm_owner = NULL;
+		chMtxUnlock(&comm_mtx);
+	}
+}
+
+/* IRQ status is only updated from threads, a short critical section is enough */
+void hydranfc_v2_protect_irq_status(void)
+{
+	chSysLock();
+}
+
+void hydranfc_v2_unprotect_irq_status(void)
+{
+	chSysUnlock();
+}
+
+void hydranfc_v2_protect_worker(void)
+{
+	chMtxLock(&rfal_worker_mtx);
+}
+
+void hydranfc_v2_unprotect_worker(void)
+{
+	chMtxUnlock(&rfal_worker_mtx);
+}
+
+static THD_FUNCTION(rfal_worker, arg)
+{
+	(void)arg;
+
+	chRegSetThreadName("RFAL worker");
+
+	while (!chThdShouldTerminateX()) {
+		/* A processed frame moves the state on, run it again at once */
+		if (worker_fn(worker_arg)) {
+			continue;
+		}
+		/* Sleep until the IRQ or the next RFAL timer expiry */
+		hydranfc_v2_worker_wait(WORKER_IDLE_US);
+	}
+}
+
 static ReturnCode init_RFAL(t_hydra_console *con)
 {
 	ReturnCode err;
@@ -152,11 +280,13 @@ static bool init_gpio_spi_nfc(t_hydra_console *con, irq_callback_t st25r3916_irq
 	palSetPadMode(GPIOA, 1, PAL_MODE_INPUT | PAL_STM32_OSPEED_MID1);
 	/* Activates the PAL driver callback */
 	//palDisablePadEvent(GPIOA, 1);
+	/* Init st25r3916 IRQ function callback */
+	st25r3916_irq_fn = st25r3916_irq_callback;
+	irq_thread_start();
+
 	palEnablePadEvent(GPIOA, 1, PAL_EVENT_MODE_RISING_EDGE);
 	palSetPadCallback(GPIOA, 1, &extcb1, NULL);
 
-	/* Init st25r3916 IRQ function callback */
-	st25r3916_irq_fn = st25r3916_irq_callback;
 	hal_st25r3916_spiInit(ST25R391X_SPI_DEVICE);
 	if (init_RFAL(con) != ERR_NONE) {
 		cprintf(con, "HydraNFC v2 not found.\r\n");
@@ -171,7 +301,9 @@ static void deinit_gpio_spi_nfc(t_hydra_console *con)
 	palClearPad(GPIOA, 1);
 	palSetPadMode(GPIOA, 1, PAL_MODE_INPUT);
 	palDisablePadEvent(GPIOA, 1);
+	irq_thread_stop();
 
+	hal_st25r3916_spiDeinit();
 	bsp_spi_deinit(BSP_DEV_SPI2);
 
 	bsp_gpio_init(BSP_GPIO_PORTA, 5, MODE_CONFIG_DEV_GPIO_IN, MODE_CONFIG_DEV_GPIO_NOPULL);
@@ -218,6 +350,7 @@ bool hydranfc_v2_init(t_hydra_console *con, irq_callback_t st25r3916_irq_callbac
  */
 void hydranfc_v2_cleanup(t_hydra_console *con)
 {
+	hydranfc_v2_worker_stop();
 	deinit_gpio_spi_nfc(con);
 }
 
@@ -225,3 +358,72 @@ void hydranfc_v2_set_irq(irq_callback_t st25r3916_irq_callback)
 {
 	st25r3916_irq_fn = st25r3916_irq_callback;
 }
+
+/** \brief Wait for the ST25R3916 IRQ or the next RFAL timer expiry
+ *
+ * \param max_us uint32_t: maximum time to sleep in microseconds
+ * \return bool: TRUE if woken by the IRQ or a RFAL timer, FALSE on max_us timeout
+ *
+ */
+bool hydranfc_v2_worker_wait(uint32_t max_us)
+{
+	uint32_t next_us;
+	bool on_timer = FALSE;
+
+	if (timerGetNextExpiry(&next_us) && (next_us < max_us)) {
+		max_us = next_us;
+		on_timer = TRUE;
+	}
+
+	if (chBSemWaitTimeout(&worker_sem, TIME_US2I(max_us)) == MSG_OK) {
+		uint32_t latency = bsp_get_cyclecounter() - worker_irq_cycles;
+
+		worker_stats.irq_wakeups++;
+		worker_stats.latency_last = latency;
+		worker_stats.latency_sum += latency;
+		if (latency > worker_stats.latency_max) {
+			worker_stats.latency_max = latency;
+		}
+		return TRUE;
+	}
+	worker_stats.timer_wakeups++;
+	return on_timer;
+}
+
+/** \brief Run fn in a dedicated thread sleeping between ST25R3916 events
+ *
+ * \param fn hydranfc_v2_worker_fn_t: returns TRUE when it processed something
+ * \param arg void*: argument given to fn
+ * \return bool: return TRUE if success or FALSE if the thread was not created
+ *
+ */
+bool hydranfc_v2_worker_start(hydranfc_v2_worker_fn_t fn, void *arg)
+{
+	if (worker_thread != NULL) {
+		return FALSE;
+	}
+	worker_fn = fn;
+	worker_arg = arg;
+	memset(&worker_stats, 0, sizeof(worker_stats));
+	chBSemReset(&worker_sem, true);
+
+	worker_thread = chThdCreateFromHeap(NULL, CONSOLE_WA_SIZE, "rfal_worker",
+					    NORMALPRIO, rfal_worker, NULL);
+	return (worker_thread != NULL);
+}
+
+void hydranfc_v2_worker_stop(void)
+{
+	if (worker_thread == NULL) {
+		return;
+	}
+	chThdTerminate(worker_thread);
+	chBSemSignal(&worker_sem);
+	chThdWait(worker_thread);
+	worker_thread = NULL;
+}
+
+const hydranfc_v2_worker_stats_t *hydranfc_v2_worker_stats(void)
+{
+	return &worker_stats;
+}
@@ -46,6 +46,38 @@
 #define D4_OFF (palClearPad(GPIOB, 5))
 
 typedef void (*irq_callback_t)(void);
+typedef bool (*hydranfc_v2_worker_fn_t)(void *arg);
+
+typedef struct {
+	uint32_t irqs; /* ST25R3916 IRQs */
+	uint32_t irq_wakeups; /* Worker woken by the IRQ */
+	uint32_t timer_wakeups; /* Worker woken by a timeout */
+	uint32_t latency_last; /* IRQ to worker latency in CPU cycles */
+	uint32_t latency_max;
+	uint64_t latency_sum;
+} hydranfc_v2_worker_stats_t;
+
+typedef enum {
+	HYDRANFC_V2_PROF_POLL, /* Technology detection poll cycle */
+	HYDRANFC_V2_PROF_ANTICOL, /* Collision resolution and activation */
+	HYDRANFC_V2_PROF_APDU, /* Reader APDU exchange, chaining included */
+	HYDRANFC_V2_PROF_CE_RESPONSE, /* Card emulation command processing and answer */
+	HYDRANFC_V2_PROF_NB
+} hydranfc_v2_prof_op_t;
+
+typedef struct {
+	uint32_t count;
+	uint32_t transactions; /* ST25R3916 SPI transactions */
+	uint32_t bytes; /* ST25R3916 SPI bytes */
+	uint32_t us; /* Total time */
+	uint32_t us_max;
+} hydranfc_v2_prof_t;
+
+typedef struct {
+	uint32_t transactions;
+	uint32_t bytes;
+	uint32_t us;
+} hydranfc_v2_prof_mark_t;
 
 bool hydranfc_v2_is_detected(void);
 
@@ -54,5 +86,15 @@ void hydranfc_v2_set_irq(irq_callback_t st25r3916_irq_callback);
 
 void hydranfc_v2_cleanup(t_hydra_console *con);
 
+bool hydranfc_v2_worker_wait(uint32_t max_us);
+bool hydranfc_v2_worker_start(hydranfc_v2_worker_fn_t fn, void *arg);
+void hydranfc_v2_worker_stop(void);
+const hydranfc_v2_worker_stats_t *hydranfc_v2_worker_stats(void);
+
+void hydranfc_v2_prof_start(hydranfc_v2_prof_mark_t *mark);
+void hydranfc_v2_prof_stop(hydranfc_v2_prof_op_t op, const hydranfc_v2_prof_mark_t *mark);
+const hydranfc_v2_prof_t *hydranfc_v2_prof_get(hydranfc_v2_prof_op_t op);
+void hydranfc_v2_prof_reset(void);
+
 #endif /* _HYDRANFC_V2_H_ */
 
@@ -1,5 +1,6 @@
 # List of all the hydranfc related files.
 HYDRANFC_V2_SRC = hydranfc_v2/hydranfc_v2.c \
+                  hydranfc_v2/hydranfc_v2_prof.c \
                   hydranfc_v2/hydranfc_v2_nfc_mode.c \
                   hydranfc_v2/hydranfc_v2_dnfc_mode.c \
                   hydranfc_v2/hydranfc_v2_ce.c \
@@ -321,7 +321,8 @@ static void ceHandler(void) {
 	}
 }
 
-static void ceRun(void) {
+static bool ceRun(void *arg) {
+	(void)arg;
 	ReturnCode err = ERR_NONE;
 	uint16_t dataSize;
 
@@ -337,8 +338,9 @@ static void ceRun(void) {
 
 		dataSize = (*current_processCmdPtr)(rxtxFrameBuf, dataSize, rxtxFrameBuf);
 		ceSetTx(CARDEMULATION_CMD_SET_TX_A, rxtxFrameBuf, dataSize);
-
+		return TRUE;
 	}
+	return FALSE;
 }
 
 static void hydranfc_ce_set_processCmd_ptr(void *ptr) {
@@ -405,9 +407,16 @@ static void bbio_iso4443_raw_ce_common(void) {
 
 	err = ceStart();
 	if (err == ERR_NONE) {
-		while (!hydrabus_ubtn()) {
-			ceRun();
-			chThdYield();
+		if (hydranfc_v2_worker_start(ceRun, NULL)) {
+			while (!hydrabus_ubtn()) {
+				chThdSleepMilliseconds(10);
+			}
+			hydranfc_v2_worker_stop();
+		} else {
+			while (!hydrabus_ubtn()) {
+				ceRun(NULL);
+				chThdYield();
+			}
 		}
 
 		ceStop();
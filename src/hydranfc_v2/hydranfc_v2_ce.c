@@ -535,7 +535,7 @@ void dispatcherInterruptHandler()
 	}
 }
 
-static void ceRun(t_hydra_console *con, bool quiet)
+static bool ceRun(t_hydra_console *con, bool quiet)
 {
 	(void)con;
 	(void)quiet;
@@ -543,6 +543,7 @@ static void ceRun(t_hydra_console *con, bool quiet)
 	uint16_t dataSize;
 	int i;
 	bool is_card_reset_needed = false;
+	hydranfc_v2_prof_mark_t prof_mark;
 
 	dispatcherInterruptHandler(); // 2.5 uS
 
@@ -553,6 +554,7 @@ static void ceRun(t_hydra_console *con, bool quiet)
 	err = ceGetRx(CARDEMULATION_CMD_GET_RX_A, rxtxFrameBuf, &dataSize);
 
 	if(err == ERR_NONE) {
+		hydranfc_v2_prof_start(&prof_mark);
 		printf_dbg("rx:");
 		for (i = 0; i < (dataSize > 16? 16 : dataSize); i++)
 			printf_dbg(" %02X", rxtxFrameBuf[i]);
@@ -560,6 +562,7 @@ static void ceRun(t_hydra_console *con, bool quiet)
 
 		dataSize = (*current_processCmdPtr)(rxtxFrameBuf, dataSize, rxtxFrameBuf, &is_card_reset_needed);
 		err = ceSetTx(CARDEMULATION_CMD_SET_TX_A, rxtxFrameBuf, dataSize, is_card_reset_needed);
+		hydranfc_v2_prof_stop(HYDRANFC_V2_PROF_CE_RESPONSE, &prof_mark);
 
 		if(err != ERR_NONE) {
 			printf_dbg("ceSetTx err %d\r\n", err);
@@ -571,7 +574,7 @@ static void ceRun(t_hydra_console *con, bool quiet)
 		for (i = 0; i < (dataSize > 16? 16 : dataSize); i++)
 			printf_dbg(" %02X", rxtxFrameBuf[i]);
 		printf_dbg("\r\n");
-
+		return TRUE;
 	} else {
 		switch(err) {
 		case ERR_NOTFOUND:
@@ -584,6 +587,12 @@ static void ceRun(t_hydra_console *con, bool quiet)
 			break;
 		}
 	}
+	return FALSE;
+}
+
+static bool ceWorker(void *arg)
+{
+	return ceRun((t_hydra_console *)arg, TRUE);
 }
 
 void hydranfc_ce_set_processCmd_ptr(void * ptr)
@@ -666,14 +675,34 @@ void hydranfc_ce_common(t_hydra_console *con, bool quiet)
 			cprintf(con, "CE started. Press user button to stop.\r\n");
 		}
 
-		while (!hydrabus_ubtn()) {
-			ceRun(con, quiet);
-			chThdYield();
+		if (hydranfc_v2_worker_start(ceWorker, con)) {
+			while (!hydrabus_ubtn()) {
+				chThdSleepMilliseconds(10);
+			}
+			hydranfc_v2_worker_stop();
+		} else {
+			while (!hydrabus_ubtn()) {
+				ceRun(con, quiet);
+				chThdYield();
+			}
 		}
 
 		ceStop();
 		if (quiet != TRUE) {
+			const hydranfc_v2_worker_stats_t *stats = hydranfc_v2_worker_stats();
+			uint32_t avg = 0;
+
+			if (stats->irq_wakeups > 0) {
+				avg = stats->latency_sum / stats->irq_wakeups;
+			}
 			cprintf(con, "CE finished\r\n");
+			cprintf(con, "IRQs: %lu, worker wakeups irq/timeout: %lu/%lu\r\n",
+				(unsigned long)stats->irqs,
+				(unsigned long)stats->irq_wakeups,
+				(unsigned long)stats->timer_wakeups);
+			cprintf(con, "IRQ to worker latency avg/max: %lu/%lu us\r\n",
+				(unsigned long)(avg / (STM32_SYSCLK / 1000000)),
+				(unsigned long)(stats->latency_max / (STM32_SYSCLK / 1000000)));
 		}
 	} else {
 		if (quiet != TRUE) {
@@ -261,15 +261,22 @@ static int exec(t_hydra_console *con, t_tokenline_parsed *p, int token_pos)
 	switch (action) {
 	case T_SET_NFC_MODE: {
 		ReturnCode err;
+		st25r3916ComStats stats;
 		cprintf(con, "nfc-mode = %d\r\n", nfc_mode);
 		cprintf(con, "nfc-mode-tx_br = %d\r\n", nfc_mode_tx_br);
 		cprintf(con, "nfc-mode-rx_br = %d\r\n", nfc_mode_rx_br);
+		st25r3916ResetComStats();
 		err = rfalSetMode(nfc_mode, nfc_mode_tx_br, nfc_mode_rx_br);
+		st25r3916GetComStats(&stats);
 		if (err == ERR_NONE) {
 			cprintf(con, "rfalSetMode OK\r\n");
 		} else {
 			cprintf(con, "rfalSetMode Error %d\r\n", err);
 		}
+		cprintf(con, "SPI: %lu transactions, %lu bytes, %lu cached reads, %lu streams, %lu errors\r\n",
+			(unsigned long)stats.transactions, (unsigned long)stats.bytes,
+			(unsigned long)stats.shadowHits, (unsigned long)stats.streams,
+			(unsigned long)stats.errors);
 	}
 	break;
 
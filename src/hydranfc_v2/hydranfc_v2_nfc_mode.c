@@ -982,6 +982,34 @@ static int exec(t_hydra_console *con, t_tokenline_parsed *p, int token_pos)
 	return t - token_pos;
 }
 
+static void show_profile(t_hydra_console *con)
+{
+	static const char * const op_str[HYDRANFC_V2_PROF_NB] = {
+		[HYDRANFC_V2_PROF_POLL] = "Poll cycle",
+		[HYDRANFC_V2_PROF_ANTICOL] = "Anticollision",
+		[HYDRANFC_V2_PROF_APDU] = "APDU",
+		[HYDRANFC_V2_PROF_CE_RESPONSE] = "CE response",
+	};
+	const hydranfc_v2_prof_t *pr;
+	int i;
+
+	cprintf(con, "Operation      Count  SPI xfers/op  Bytes/op  Avg us  Max us\r\n");
+	for (i = 0; i < HYDRANFC_V2_PROF_NB; i++) {
+		pr = hydranfc_v2_prof_get(i);
+		if (pr->count == 0) {
+			cprintf(con, "%-13s  %5d\r\n", op_str[i], 0);
+			continue;
+		}
+		cprintf(con, "%-13s  %5lu  %12lu  %8lu  %6lu  %6lu\r\n", op_str[i],
+			(unsigned long)pr->count,
+			(unsigned long)(pr->transactions / pr->count),
+			(unsigned long)(pr->bytes / pr->count),
+			(unsigned long)(pr->us / pr->count),
+			(unsigned long)pr->us_max);
+	}
+	hydranfc_v2_prof_reset();
+}
+
 static void show_registers(t_hydra_console *con)
 {
 	ReturnCode err;
@@ -1036,6 +1064,9 @@ static int show(t_hydra_console *con, t_tokenline_parsed *p)
 	if (p->tokens[1] == T_REGISTERS) {
 		tokens_used++;
 		show_registers(con);
+	} else if (p->tokens[1] == T_PROFILE) {
+		tokens_used++;
+		show_profile(con);
 	} else {
 		nfc_technology_to_str(proto->config.hydranfc.nfc_technology, &tag_tech_str);
 		cprintf(con, "Selected technology: NFC-%s\r\n", tag_tech_str.str);
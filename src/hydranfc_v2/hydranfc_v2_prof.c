@@ -0,0 +1,79 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* NFC operation profiling, kept apart from the ChibiOS glue so it also runs in the host build (test/) */
+
+#include <string.h>
+
+#include "platform.h"
+#include "st25r3916_com.h"
+
+#include "hydranfc_v2.h"
+
+/* One entry per profiled operation, indexed by hydranfc_v2_prof_op_t */
+static hydranfc_v2_prof_t prof[HYDRANFC_V2_PROF_NB];
+
+/** \brief Mark the start of a profiled NFC operation
+ *
+ * \param mark hydranfc_v2_prof_mark_t*: filled with current counters
+ * \return void
+ *
+ */
+void hydranfc_v2_prof_start(hydranfc_v2_prof_mark_t *mark)
+{
+	st25r3916ComStats stats;
+
+	st25r3916GetComStats(&stats);
+	mark->transactions = stats.transactions;
+	mark->bytes = stats.bytes;
+	mark->us = timerGetUs();
+}
+
+/** \brief Account a profiled NFC operation started with hydranfc_v2_prof_start()
+ *
+ * \param op hydranfc_v2_prof_op_t: operation
+ * \param mark hydranfc_v2_prof_mark_t*: counters at operation start
+ * \return void
+ *
+ */
+void hydranfc_v2_prof_stop(hydranfc_v2_prof_op_t op, const hydranfc_v2_prof_mark_t *mark)
+{
+	st25r3916ComStats stats;
+	uint32_t us;
+
+	us = timerGetUs() - mark->us;
+	st25r3916GetComStats(&stats);
+
+	prof[op].count++;
+	prof[op].transactions += stats.transactions - mark->transactions;
+	prof[op].bytes += stats.bytes - mark->bytes;
+	prof[op].us += us;
+	if (us > prof[op].us_max) {
+		prof[op].us_max = us;
+	}
+}
+
+const hydranfc_v2_prof_t *hydranfc_v2_prof_get(hydranfc_v2_prof_op_t op)
+{
+	return &prof[op];
+}
+
+void hydranfc_v2_prof_reset(void)
+{
+	memset(prof, 0, sizeof(prof));
+}
@@ -232,7 +232,9 @@ void send_apdu(t_hydra_console *con, uint8_t *apdu, uint32_t len)
 {
 	uint8_t i;
 	int r_len;
+	hydranfc_v2_prof_mark_t prof_mark;
 
+	hydranfc_v2_prof_start(&prof_mark);
 	init_iso_14443_session();
 
 	i = 0;
@@ -267,6 +269,7 @@ void send_apdu(t_hydra_console *con, uint8_t *apdu, uint32_t len)
 		memcpy(&rapdu_buffer[rapdu_len], tpdu.inf, tpdu.len);
 		rapdu_len += tpdu.len;
 	}
+	hydranfc_v2_prof_stop(HYDRANFC_V2_PROF_APDU, &prof_mark);
 
 	pretty_print_hex_buf(con, rapdu_buffer, rapdu_len);
 
@@ -57,6 +57,10 @@
 
 
 #define RFAL_TEST_REG         0x0080U      /*!< Test Register indicator  */    
+#define RFAL_REG_BANK_MASK    0x003FU      /*!< Registers are auto-incremented within banks of 64 (Space A/B) */
+#define RFAL_ANALOG_CONFIG_RUN_MAX        16U  /*!< Max registers merged in a single burst write */
+#define RFAL_ANALOG_CONFIG_INDEX_SIZE     32U  /*!< Number of Configuration IDs kept in the index */
+#define RFAL_ANALOG_CONFIG_INDEX_SETS     4U   /*!< Max Configuration Sets kept per Configuration ID */
 
 /*
  ******************************************************************************
@@ -84,6 +88,22 @@ typedef struct {
 
 static rfalAnalogConfigMgmt   gRfalAnalogConfigMgmt;  /*!< Analog Configuration LUT management */
 
+/*! Configuration Sets found for a Configuration ID, filled on first use */
+typedef struct {
+    rfalAnalogConfigId     id;                                      /*!< Configuration ID                          */
+    uint8_t                numSets;                                 /*!< Number of Configuration Sets found        */
+    rfalAnalogConfigOffset offset[RFAL_ANALOG_CONFIG_INDEX_SETS];   /*!< Offset of each set's first Reg-Mask-Value */
+} rfalAnalogConfigIndexEntry;
+
+/*! Per Configuration ID index of the current table */
+typedef struct {
+    rfalAnalogConfigIndexEntry entry[RFAL_ANALOG_CONFIG_INDEX_SIZE]; /*!< Indexed Configuration IDs              */
+    uint8_t                    count;                                /*!< Number of valid entries                 */
+    uint8_t                    next;                                 /*!< Entry replaced when the index is full   */
+} rfalAnalogConfigIndex;
+
+static rfalAnalogConfigIndex  gRfalAnalogConfigIndex; /*!< Analog Configuration index */
+
 /*
  ******************************************************************************
  * LOCAL TABLES
@@ -96,6 +116,8 @@ static rfalAnalogConfigMgmt   gRfalAnalogConfigMgmt;  /*!< Analog Configuration
  ******************************************************************************
  */
 static rfalAnalogConfigNum rfalAnalogConfigSearch( rfalAnalogConfigId configId, uint16_t *configOffset );
+static const rfalAnalogConfigIndexEntry* rfalAnalogConfigIndexGet( rfalAnalogConfigId configId );
+static ReturnCode rfalAnalogConfigApplySet( const rfalAnalogConfigRegAddrMaskVal *configTbl, rfalAnalogConfigNum numConfigSet );
 
 #if RFAL_FEATURE_DYNAMIC_ANALOG_CONFIG
     static void rfalAnalogConfigPtrUpdate( const uint8_t* analogConfigTbl );
@@ -126,6 +148,7 @@ void rfalAnalogConfigInitialize( void )
     gRfalAnalogConfigMgmt.configTblSize          = sizeof(rfalAnalogConfigDefaultSettings);
 #endif
   
+  gRfalAnalogConfigIndex.count = 0;
   gRfalAnalogConfigMgmt.ready = true;
 } /* rfalAnalogConfigInitialize() */
 
@@ -181,6 +204,7 @@ ReturnCode rfalAnalogConfigListWrite( uint8_t more, const rfalAnalogConfig *conf
 
     if (true == gRfalAnalogConfigMgmt.ready)
     {   /* First Update to the Configuration list. */
+        gRfalAnalogConfigIndex.count = 0;      // invalidate the index
         gRfalAnalogConfigMgmt.ready = false;   // invalidate the config List
         gRfalAnalogConfigMgmt.configTblSize = 0; // Clear the config List
     }
@@ -292,14 +316,29 @@ ReturnCode rfalSetAnalogConfig( rfalAnalogConfigId configId )
     rfalAnalogConfigOffset configOffset = 0;
     rfalAnalogConfigNum numConfigSet;
     const rfalAnalogConfigRegAddrMaskVal *configTbl;
+    const rfalAnalogConfigIndexEntry *entry;
     ReturnCode retCode = ERR_NONE;
-    rfalAnalogConfigNum i;
+    uint8_t i;
     
     if (true != gRfalAnalogConfigMgmt.ready)
     {
         return ERR_REQUEST;
     }
     
+    /* Use the Configuration Sets already found for this ID */
+    entry = rfalAnalogConfigIndexGet( configId );
+    if( entry != NULL )
+    {
+        for( i = 0; i < entry->numSets; i++ )
+        {
+            configOffset = entry->offset[i];
+            numConfigSet = gRfalAnalogConfigMgmt.currentAnalogConfigTbl[configOffset - sizeof(rfalAnalogConfigNum)];
+            configTbl    = (const rfalAnalogConfigRegAddrMaskVal *)&gRfalAnalogConfigMgmt.currentAnalogConfigTbl[configOffset];
+            EXIT_ON_ERR( retCode, rfalAnalogConfigApplySet( configTbl, numConfigSet ) );
+        }
+        return retCode;
+    }
+    
     /* Search LUT for the specific Configuration ID. */
     while(true)
     {
@@ -318,17 +357,7 @@ ReturnCode rfalSetAnalogConfig( rfalAnalogConfigId configId )
             return ERR_NOMEM;
         }
         
-        for ( i = 0; i < numConfigSet; i++)
-        {
-            if( (GETU16(configTbl[i].addr) & RFAL_TEST_REG) != 0U )
-            {
-                EXIT_ON_ERR(retCode, rfalChipChangeTestRegBits( (GETU16(configTbl[i].addr) & ~RFAL_TEST_REG), configTbl[i].mask, configTbl[i].val) );
-            }
-            else
-            {
-                EXIT_ON_ERR(retCode, rfalChipChangeRegBits( GETU16(configTbl[i].addr), configTbl[i].mask, configTbl[i].val) );
-            }
-        }
+        EXIT_ON_ERR( retCode, rfalAnalogConfigApplySet( configTbl, numConfigSet ) );
         
     } /* while(found Analog Config Id) */
     
@@ -412,6 +441,7 @@ static void rfalAnalogConfigPtrUpdate( const uint8_t* analogConfigTbl )
 {
 
     gRfalAnalogConfigMgmt.currentAnalogConfigTbl = analogConfigTbl;
+    gRfalAnalogConfigIndex.count = 0;
     gRfalAnalogConfigMgmt.ready = true;
     
 } /* rfalAnalogConfigPtrUpdate() */
@@ -472,3 +502,151 @@ static rfalAnalogConfigNum rfalAnalogConfigSearch( rfalAnalogConfigId configId,
     
     return RFAL_ANALOG_CONFIG_LUT_NOT_FOUND;
 } /* rfalAnalogConfigSearch() */
+
+
+/*! 
+ *****************************************************************************
+ * \brief  Get the index entry of a Configuration ID
+ *  
+ * Returns the Configuration Sets of the ID, searching the whole table
+ * only the first time the ID is used since the table was loaded.
+ * 
+ * \param[in]  configId: Configuration ID to search for.
+ * 
+ * \return entry of the Configuration ID
+ * \return NULL if the ID has more sets than an entry can hold
+ *****************************************************************************
+ */
+static const rfalAnalogConfigIndexEntry* rfalAnalogConfigIndexGet( rfalAnalogConfigId configId )
+{
+    rfalAnalogConfigIndexEntry newEntry;
+    rfalAnalogConfigIndexEntry *entry;
+    rfalAnalogConfigOffset configOffset;
+    rfalAnalogConfigNum numConfigSet;
+    uint8_t i;
+    
+    for( i = 0; i < gRfalAnalogConfigIndex.count; i++ )
+    {
+        if( gRfalAnalogConfigIndex.entry[i].id == configId )
+        {
+            return &gRfalAnalogConfigIndex.entry[i];
+        }
+    }
+    
+    /* Build the entry aside, the index is only modified once it is complete */
+    newEntry.id      = configId;
+    newEntry.numSets = 0;
+    configOffset     = 0;
+    while( true )
+    {
+        numConfigSet = rfalAnalogConfigSearch( configId, &configOffset );
+        if( RFAL_ANALOG_CONFIG_LUT_NOT_FOUND == numConfigSet )
+        {
+            break;
+        }
+        if( (newEntry.numSets >= RFAL_ANALOG_CONFIG_INDEX_SETS) || 
+            ((configOffset + (numConfigSet * sizeof(rfalAnalogConfigRegAddrMaskVal))) > gRfalAnalogConfigMgmt.configTblSize) )
+        {
+            /* Not indexable, keep on searching the table for this ID */
+            return NULL;
+        }
+        newEntry.offset[newEntry.numSets++] = configOffset;
+        configOffset += (uint16_t)(numConfigSet * sizeof(rfalAnalogConfigRegAddrMaskVal));
+    }
+    
+    /* Replace the oldest entry once the index is full */
+    if( gRfalAnalogConfigIndex.count < RFAL_ANALOG_CONFIG_INDEX_SIZE )
+    {
+        entry = &gRfalAnalogConfigIndex.entry[gRfalAnalogConfigIndex.count];
+        gRfalAnalogConfigIndex.count++;
+    }
+    else
+    {
+        entry = &gRfalAnalogConfigIndex.entry[gRfalAnalogConfigIndex.next];
+        gRfalAnalogConfigIndex.next = (uint8_t)((gRfalAnalogConfigIndex.next + 1U) % RFAL_ANALOG_CONFIG_INDEX_SIZE);
+    }
+    
+    ST_MEMCPY( entry, &newEntry, sizeof(rfalAnalogConfigIndexEntry) );
+    return entry;
+} /* rfalAnalogConfigIndexGet() */
+
+
+/*! 
+ *****************************************************************************
+ * \brief  Apply a Configuration Set
+ *  
+ * Register-Mask-Value entries on consecutive register addresses are merged,
+ * each stretch of consecutive modified registers is written with a single
+ * burst. Registers left unchanged by the set are not written.
+ * 
+ * \param[in]  configTbl: first Register-Mask-Value of the set
+ * \param[in]  numConfigSet: number of Register-Mask-Value in the set
+ * 
+ * \return ERR_NONE or the error of the register access
+ *****************************************************************************
+ */
+static ReturnCode rfalAnalogConfigApplySet( const rfalAnalogConfigRegAddrMaskVal *configTbl, rfalAnalogConfigNum numConfigSet )
+{
+    uint8_t    runOld[RFAL_ANALOG_CONFIG_RUN_MAX];
+    uint8_t    runNew[RFAL_ANALOG_CONFIG_RUN_MAX];
+    uint16_t   runStart = 0;
+    uint8_t    runLen = 0;
+    uint8_t    first;
+    uint8_t    last;
+    uint16_t   addr;
+    uint16_t   pos;
+    ReturnCode retCode;
+    uint16_t   i;
+    
+    for( i = 0; i <= (uint16_t)numConfigSet; i++ )
+    {
+        addr = (i < numConfigSet) ? GETU16(configTbl[i].addr) : 0U;
+        pos  = (uint16_t)(addr - runStart);
+        
+        /* Extend the current run with the same or the next register */
+        if( (i < numConfigSet) && (runLen > 0U) && ((addr & RFAL_TEST_REG) == 0U) && (addr >= runStart) &&
+            (pos <= runLen) && (pos < RFAL_ANALOG_CONFIG_RUN_MAX) && ((addr & ~RFAL_REG_BANK_MASK) == (runStart & ~RFAL_REG_BANK_MASK)) )
+        {
+            if( pos == runLen )
+            {
+                EXIT_ON_ERR( retCode, rfalChipReadReg( addr, &runOld[pos], 1 ) );
+                runNew[pos] = runOld[pos];
+                runLen++;
+            }
+            runNew[pos] = (uint8_t)((runNew[pos] & ~configTbl[i].mask) | (configTbl[i].val & configTbl[i].mask));
+            continue;
+        }
+        
+        /* Burst write each stretch of modified registers of the current run, *
+         * the registers left unchanged in between are not rewritten          */
+        for( first = 0; first < runLen; first = last )
+        {
+            for( ; (first < runLen) && (runOld[first] == runNew[first]); first++ ) {}
+            for( last = first; (last < runLen) && (runOld[last] != runNew[last]); last++ ) {}
+            if( last > first )
+            {
+                EXIT_ON_ERR( retCode, rfalChipWriteReg( (uint16_t)(runStart + first), &runNew[first], (uint8_t)(last - first) ) );
+            }
+        }
+        runLen = 0;
+        
+        if( i == numConfigSet )
+        {
+            break;
+        }
+        
+        if( (addr & RFAL_TEST_REG) != 0U )
+        {
+            EXIT_ON_ERR( retCode, rfalChipChangeTestRegBits( (addr & ~RFAL_TEST_REG), configTbl[i].mask, configTbl[i].val) );
+            continue;
+        }
+        
+        /* Start a new run */
+        runStart = addr;
+        EXIT_ON_ERR( retCode, rfalChipReadReg( addr, &runOld[0], 1 ) );
+        runNew[0] = (uint8_t)((runOld[0] & ~configTbl[i].mask) | (configTbl[i].val & configTbl[i].mask));
+        runLen = 1;
+    }
+    
+    return ERR_NONE;
+} /* rfalAnalogConfigApplySet() */
@@ -78,6 +78,7 @@
 #define ISO15693_DAT_SLOT3_1_256 0x80
 
 #define ISO15693_PHY_DAT_MANCHESTER_1 0xaaaa
+#define ISO15693_PHY_MANCHESTER_INV   0x10U  /*!< Marks a manchester table entry holding a collision/invalid pair */
 
 #define ISO15693_PHY_BIT_BUFFER_SIZE 1000 /*!< size of the receiving buffer. Might be adjusted if longer datastreams are expected. */
 
@@ -89,6 +90,103 @@
 */
 static rfalIso15693PhyConfig_t gIso15693PhyConfig; /*!< current phy configuration */
 
+/*! 1 of 4 coding of a full data byte: 4 ISO15693_DAT_xx_1_4 symbols, lowest bit pair first */
+static const uint8_t gIso15693Code1Of4Tbl[256][4] =
+{
+    { 0x02, 0x02, 0x02, 0x02 }, { 0x08, 0x02, 0x02, 0x02 }, { 0x20, 0x02, 0x02, 0x02 }, { 0x80, 0x02, 0x02, 0x02 },
+    { 0x02, 0x08, 0x02, 0x02 }, { 0x08, 0x08, 0x02, 0x02 }, { 0x20, 0x08, 0x02, 0x02 }, { 0x80, 0x08, 0x02, 0x02 },
+    { 0x02, 0x20, 0x02, 0x02 }, { 0x08, 0x20, 0x02, 0x02 }, { 0x20, 0x20, 0x02, 0x02 }, { 0x80, 0x20, 0x02, 0x02 },
+    { 0x02, 0x80, 0x02, 0x02 }, { 0x08, 0x80, 0x02, 0x02 }, { 0x20, 0x80, 0x02, 0x02 }, { 0x80, 0x80, 0x02, 0x02 },
+    { 0x02, 0x02, 0x08, 0x02 }, { 0x08, 0x02, 0x08, 0x02 }, { 0x20, 0x02, 0x08, 0x02 }, { 0x80, 0x02, 0x08, 0x02 },
+    { 0x02, 0x08, 0x08, 0x02 }, { 0x08, 0x08, 0x08, 0x02 }, { 0x20, 0x08, 0x08, 0x02 }, { 0x80, 0x08, 0x08, 0x02 },
+    { 0x02, 0x20, 0x08, 0x02 }, { 0x08, 0x20, 0x08, 0x02 }, { 0x20, 0x20, 0x08, 0x02 }, { 0x80, 0x20, 0x08, 0x02 },
+    { 0x02, 0x80, 0x08, 0x02 }, { 0x08, 0x80, 0x08, 0x02 }, { 0x20, 0x80, 0x08, 0x02 }, { 0x80, 0x80, 0x08, 0x02 },
+    { 0x02, 0x02, 0x20, 0x02 }, { 0x08, 0x02, 0x20, 0x02 }, { 0x20, 0x02, 0x20, 0x02 }, { 0x80, 0x02, 0x20, 0x02 },
+    { 0x02, 0x08, 0x20, 0x02 }, { 0x08, 0x08, 0x20, 0x02 }, { 0x20, 0x08, 0x20, 0x02 }, { 0x80, 0x08, 0x20, 0x02 },
+    { 0x02, 0x20, 0x20, 0x02 }, { 0x08, 0x20, 0x20, 0x02 }, { 0x20, 0x20, 0x20, 0x02 }, { 0x80, 0x20, 0x20, 0x02 },
+    { 0x02, 0x80, 0x20, 0x02 }, { 0x08, 0x80, 0x20, 0x02 }, { 0x20, 0x80, 0x20, 0x02 }, { 0x80, 0x80, 0x20, 0x02 },
+    { 0x02, 0x02, 0x80, 0x02 }, { 0x08, 0x02, 0x80, 0x02 }, { 0x20, 0x02, 0x80, 0x02 }, { 0x80, 0x02, 0x80, 0x02 },
+    { 0x02, 0x08, 0x80, 0x02 }, { 0x08, 0x08, 0x80, 0x02 }, { 0x20, 0x08, 0x80, 0x02 }, { 0x80, 0x08, 0x80, 0x02 },
+    { 0x02, 0x20, 0x80, 0x02 }, { 0x08, 0x20, 0x80, 0x02 }, { 0x20, 0x20, 0x80, 0x02 }, { 0x80, 0x20, 0x80, 0x02 },
+    { 0x02, 0x80, 0x80, 0x02 }, { 0x08, 0x80, 0x80, 0x02 }, { 0x20, 0x80, 0x80, 0x02 }, { 0x80, 0x80, 0x80, 0x02 },
+    { 0x02, 0x02, 0x02, 0x08 }, { 0x08, 0x02, 0x02, 0x08 }, { 0x20, 0x02, 0x02, 0x08 }, { 0x80, 0x02, 0x02, 0x08 },
+    { 0x02, 0x08, 0x02, 0x08 }, { 0x08, 0x08, 0x02, 0x08 }, { 0x20, 0x08, 0x02, 0x08 }, { 0x80, 0x08, 0x02, 0x08 },
+    { 0x02, 0x20, 0x02, 0x08 }, { 0x08, 0x20, 0x02, 0x08 }, { 0x20, 0x20, 0x02, 0x08 }, { 0x80, 0x20, 0x02, 0x08 },
+    { 0x02, 0x80, 0x02, 0x08 }, { 0x08, 0x80, 0x02, 0x08 }, { 0x20, 0x80, 0x02, 0x08 }, { 0x80, 0x80, 0x02, 0x08 },
+    { 0x02, 0x02, 0x08, 0x08 }, { 0x08, 0x02, 0x08, 0x08 }, { 0x20, 0x02, 0x08, 0x08 }, { 0x80, 0x02, 0x08, 0x08 },
+    { 0x02, 0x08, 0x08, 0x08 }, { 0x08, 0x08, 0x08, 0x08 }, { 0x20, 0x08, 0x08, 0x08 }, { 0x80, 0x08, 0x08, 0x08 },
+    { 0x02, 0x20, 0x08, 0x08 }, { 0x08, 0x20, 0x08, 0x08 }, { 0x20, 0x20, 0x08, 0x08 }, { 0x80, 0x20, 0x08, 0x08 },
+    { 0x02, 0x80, 0x08, 0x08 }, { 0x08, 0x80, 0x08, 0x08 }, { 0x20, 0x80, 0x08, 0x08 }, { 0x80, 0x80, 0x08, 0x08 },
+    { 0x02, 0x02, 0x20, 0x08 }, { 0x08, 0x02, 0x20, 0x08 }, { 0x20, 0x02, 0x20, 0x08 }, { 0x80, 0x02, 0x20, 0x08 },
+    { 0x02, 0x08, 0x20, 0x08 }, { 0x08, 0x08, 0x20, 0x08 }, { 0x20, 0x08, 0x20, 0x08 }, { 0x80, 0x08, 0x20, 0x08 },
+    { 0x02, 0x20, 0x20, 0x08 }, { 0x08, 0x20, 0x20, 0x08 }, { 0x20, 0x20, 0x20, 0x08 }, { 0x80, 0x20, 0x20, 0x08 },
+    { 0x02, 0x80, 0x20, 0x08 }, { 0x08, 0x80, 0x20, 0x08 }, { 0x20, 0x80, 0x20, 0x08 }, { 0x80, 0x80, 0x20, 0x08 },
+    { 0x02, 0x02, 0x80, 0x08 }, { 0x08, 0x02, 0x80, 0x08 }, { 0x20, 0x02, 0x80, 0x08 }, { 0x80, 0x02, 0x80, 0x08 },
+    { 0x02, 0x08, 0x80, 0x08 }, { 0x08, 0x08, 0x80, 0x08 }, { 0x20, 0x08, 0x80, 0x08 }, { 0x80, 0x08, 0x80, 0x08 },
+    { 0x02, 0x20, 0x80, 0x08 }, { 0x08, 0x20, 0x80, 0x08 }, { 0x20, 0x20, 0x80, 0x08 }, { 0x80, 0x20, 0x80, 0x08 },
+    { 0x02, 0x80, 0x80, 0x08 }, { 0x08, 0x80, 0x80, 0x08 }, { 0x20, 0x80, 0x80, 0x08 }, { 0x80, 0x80, 0x80, 0x08 },
+    { 0x02, 0x02, 0x02, 0x20 }, { 0x08, 0x02, 0x02, 0x20 }, { 0x20, 0x02, 0x02, 0x20 }, { 0x80, 0x02, 0x02, 0x20 },
+    { 0x02, 0x08, 0x02, 0x20 }, { 0x08, 0x08, 0x02, 0x20 }, { 0x20, 0x08, 0x02, 0x20 }, { 0x80, 0x08, 0x02, 0x20 },
+    { 0x02, 0x20, 0x02, 0x20 }, { 0x08, 0x20, 0x02, 0x20 }, { 0x20, 0x20, 0x02, 0x20 }, { 0x80, 0x20, 0x02, 0x20 },
+    { 0x02, 0x80, 0x02, 0x20 }, { 0x08, 0x80, 0x02, 0x20 }, { 0x20, 0x80, 0x02, 0x20 }, { 0x80, 0x80, 0x02, 0x20 },
+    { 0x02, 0x02, 0x08, 0x20 }, { 0x08, 0x02, 0x08, 0x20 }, { 0x20, 0x02, 0x08, 0x20 }, { 0x80, 0x02, 0x08, 0x20 },
+    { 0x02, 0x08, 0x08, 0x20 }, { 0x08, 0x08, 0x08, 0x20 }, { 0x20, 0x08, 0x08, 0x20 }, { 0x80, 0x08, 0x08, 0x20 },
+    { 0x02, 0x20, 0x08, 0x20 }, { 0x08, 0x20, 0x08, 0x20 }, { 0x20, 0x20, 0x08, 0x20 }, { 0x80, 0x20, 0x08, 0x20 },
+    { 0x02, 0x80, 0x08, 0x20 }, { 0x08, 0x80, 0x08, 0x20 }, { 0x20, 0x80, 0x08, 0x20 }, { 0x80, 0x80, 0x08, 0x20 },
+    { 0x02, 0x02, 0x20, 0x20 }, { 0x08, 0x02, 0x20, 0x20 }, { 0x20, 0x02, 0x20, 0x20 }, { 0x80, 0x02, 0x20, 0x20 },
+    { 0x02, 0x08, 0x20, 0x20 }, { 0x08, 0x08, 0x20, 0x20 }, { 0x20, 0x08, 0x20, 0x20 }, { 0x80, 0x08, 0x20, 0x20 },
+    { 0x02, 0x20, 0x20, 0x20 }, { 0x08, 0x20, 0x20, 0x20 }, { 0x20, 0x20, 0x20, 0x20 }, { 0x80, 0x20, 0x20, 0x20 },
+    { 0x02, 0x80, 0x20, 0x20 }, { 0x08, 0x80, 0x20, 0x20 }, { 0x20, 0x80, 0x20, 0x20 }, { 0x80, 0x80, 0x20, 0x20 },
+    { 0x02, 0x02, 0x80, 0x20 }, { 0x08, 0x02, 0x80, 0x20 }, { 0x20, 0x02, 0x80, 0x20 }, { 0x80, 0x02, 0x80, 0x20 },
+    { 0x02, 0x08, 0x80, 0x20 }, { 0x08, 0x08, 0x80, 0x20 }, { 0x20, 0x08, 0x80, 0x20 }, { 0x80, 0x08, 0x80, 0x20 },
+    { 0x02, 0x20, 0x80, 0x20 }, { 0x08, 0x20, 0x80, 0x20 }, { 0x20, 0x20, 0x80, 0x20 }, { 0x80, 0x20, 0x80, 0x20 },
+    { 0x02, 0x80, 0x80, 0x20 }, { 0x08, 0x80, 0x80, 0x20 }, { 0x20, 0x80, 0x80, 0x20 }, { 0x80, 0x80, 0x80, 0x20 },
+    { 0x02, 0x02, 0x02, 0x80 }, { 0x08, 0x02, 0x02, 0x80 }, { 0x20, 0x02, 0x02, 0x80 }, { 0x80, 0x02, 0x02, 0x80 },
+    { 0x02, 0x08, 0x02, 0x80 }, { 0x08, 0x08, 0x02, 0x80 }, { 0x20, 0x08, 0x02, 0x80 }, { 0x80, 0x08, 0x02, 0x80 },
+    { 0x02, 0x20, 0x02, 0x80 }, { 0x08, 0x20, 0x02, 0x80 }, { 0x20, 0x20, 0x02, 0x80 }, { 0x80, 0x20, 0x02, 0x80 },
+    { 0x02, 0x80, 0x02, 0x80 }, { 0x08, 0x80, 0x02, 0x80 }, { 0x20, 0x80, 0x02, 0x80 }, { 0x80, 0x80, 0x02, 0x80 },
+    { 0x02, 0x02, 0x08, 0x80 }, { 0x08, 0x02, 0x08, 0x80 }, { 0x20, 0x02, 0x08, 0x80 }, { 0x80, 0x02, 0x08, 0x80 },
+    { 0x02, 0x08, 0x08, 0x80 }, { 0x08, 0x08, 0x08, 0x80 }, { 0x20, 0x08, 0x08, 0x80 }, { 0x80, 0x08, 0x08, 0x80 },
+    { 0x02, 0x20, 0x08, 0x80 }, { 0x08, 0x20, 0x08, 0x80 }, { 0x20, 0x20, 0x08, 0x80 }, { 0x80, 0x20, 0x08, 0x80 },
+    { 0x02, 0x80, 0x08, 0x80 }, { 0x08, 0x80, 0x08, 0x80 }, { 0x20, 0x80, 0x08, 0x80 }, { 0x80, 0x80, 0x08, 0x80 },
+    { 0x02, 0x02, 0x20, 0x80 }, { 0x08, 0x02, 0x20, 0x80 }, { 0x20, 0x02, 0x20, 0x80 }, { 0x80, 0x02, 0x20, 0x80 },
+    { 0x02, 0x08, 0x20, 0x80 }, { 0x08, 0x08, 0x20, 0x80 }, { 0x20, 0x08, 0x20, 0x80 }, { 0x80, 0x08, 0x20, 0x80 },
+    { 0x02, 0x20, 0x20, 0x80 }, { 0x08, 0x20, 0x20, 0x80 }, { 0x20, 0x20, 0x20, 0x80 }, { 0x80, 0x20, 0x20, 0x80 },
+    { 0x02, 0x80, 0x20, 0x80 }, { 0x08, 0x80, 0x20, 0x80 }, { 0x20, 0x80, 0x20, 0x80 }, { 0x80, 0x80, 0x20, 0x80 },
+    { 0x02, 0x02, 0x80, 0x80 }, { 0x08, 0x02, 0x80, 0x80 }, { 0x20, 0x02, 0x80, 0x80 }, { 0x80, 0x02, 0x80, 0x80 },
+    { 0x02, 0x08, 0x80, 0x80 }, { 0x08, 0x08, 0x80, 0x80 }, { 0x20, 0x08, 0x80, 0x80 }, { 0x80, 0x08, 0x80, 0x80 },
+    { 0x02, 0x20, 0x80, 0x80 }, { 0x08, 0x20, 0x80, 0x80 }, { 0x20, 0x20, 0x80, 0x80 }, { 0x80, 0x20, 0x80, 0x80 },
+    { 0x02, 0x80, 0x80, 0x80 }, { 0x08, 0x80, 0x80, 0x80 }, { 0x20, 0x80, 0x80, 0x80 }, { 0x80, 0x80, 0x80, 0x80 }
+};
+
+/*! 1 of 256 coding: slot symbol for the position of data within its output byte */
+static const uint8_t gIso15693Code1Of256Slot[4] =
+{
+    ISO15693_DAT_SLOT0_1_256, ISO15693_DAT_SLOT1_1_256, ISO15693_DAT_SLOT2_1_256, ISO15693_DAT_SLOT3_1_256
+};
+
+/*! Manchester decoding of 4 bit pairs (8 received bits, first pair in LSB) into a payload nibble.
+ *  Entries containing a collision (00) or unmodulated (11) pair are ISO15693_PHY_MANCHESTER_INV */
+static const uint8_t gIso15693ManchesterTbl[256] =
+{
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x01, 0x10, 0x10, 0x02, 0x03, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x04, 0x05, 0x10, 0x10, 0x06, 0x07, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x08, 0x09, 0x10, 0x10, 0x0A, 0x0B, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x0C, 0x0D, 0x10, 0x10, 0x0E, 0x0F, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+};
+
 /*
 ******************************************************************************
 * LOCAL FUNCTION PROTOTYPES
@@ -322,6 +420,43 @@ ReturnCode rfalIso15693VICCDecode(const uint8_t *inBuf,
         bool isEOF = false;
         
         uint8_t man;
+
+        /* On a byte boundary with 8 more pairs available decode them at once. Any collision/invalid
+         * pair falls back to the bitwise path below, which handles ignoreBits and errors            */
+        if ( ((bp%8U) == 0U) && ((mp + 14U) < ((inBufLen * 8U) - 2U)) )
+        {
+            uint32_t win;
+            uint8_t  lo;
+            uint8_t  hi;
+
+            win  = (uint32_t)inBuf[mp/8U];
+            win |= ((uint32_t)inBuf[(mp/8U)+1U] << 8U);
+            win |= ((uint32_t)inBuf[(mp/8U)+2U] << 16U);
+            win >>= (mp%8U);
+
+            lo = gIso15693ManchesterTbl[win & 0xffU];
+            hi = gIso15693ManchesterTbl[(win >> 8U) & 0xffU];
+
+            if (((lo | hi) & ISO15693_PHY_MANCHESTER_INV) == 0U)
+            {
+                outBuf[bp/8U] = (uint8_t)(lo | (uint8_t)(hi << 4U));
+                bp += 8U;
+                mp += 14U;  /* Position of the last pair of this byte, as seen by the EOF check */
+
+                if ( ((inBuf[mp/8U]   & 0xe0U) == 0xa0U)
+                   &&(inBuf[(mp/8U)+1U] == 0x03U))
+                { /* Now we know that it was 10111000 = EOF */
+                    ISO_15693_DEBUG("EOF\n");
+                    isEOF = true;
+                }
+                if ( (bp >= (outBufLen * 8U)) || isEOF )
+                { /* Don't write beyond the end */
+                    break;
+                }
+                continue;
+            }
+        }
+
         man  = (inBuf[mp/8U] >> (mp%8U)) & 0x1U;
         man |= ((inBuf[(mp+1U)/8U] >> ((mp+1U)%8U)) & 0x1U) << 1;
         if (1U == man)
@@ -427,43 +562,16 @@ ReturnCode rfalIso15693VICCDecode(const uint8_t *inBuf,
  */
 static ReturnCode rfalIso15693PhyVCDCode1Of4(const uint8_t data, uint8_t* outbuffer, uint16_t maxOutBufLen, uint16_t* outBufLen)
 {
-    uint8_t tmp;
-    ReturnCode err = ERR_NONE;
-    uint16_t a;
-    uint8_t* outbuf = outbuffer;
-
     *outBufLen = 0;
 
     if (maxOutBufLen < 4U) {
         return ERR_NOMEM;
     }
 
-    tmp = data;
-    for (a = 0; a < 4U; a++)
-    {
-        switch (tmp & 0x3U)
-        {
-            case 0:
-                *outbuf = ISO15693_DAT_00_1_4;
-                break;
-            case 1:
-                *outbuf = ISO15693_DAT_01_1_4;
-                break;
-            case 2:
-                *outbuf = ISO15693_DAT_10_1_4;
-                break;
-            case 3:
-                *outbuf = ISO15693_DAT_11_1_4;
-                break;
-            default:
-                /* MISRA 16.4: mandatory default statement */
-                break;
-        }
-        outbuf++;
-        (*outBufLen)++;
-        tmp >>= 2;
-    }
-    return err;
+    ST_MEMCPY(outbuffer, gIso15693Code1Of4Tbl[data], 4U);
+    *outBufLen = 4U;
+
+    return ERR_NONE;
 }
 
 /*! 
@@ -485,44 +593,18 @@ static ReturnCode rfalIso15693PhyVCDCode1Of4(const uint8_t data, uint8_t* outbuf
  */
 static ReturnCode rfalIso15693PhyVCDCode1Of256(const uint8_t data, uint8_t* outbuffer, uint16_t maxOutBufLen, uint16_t* outBufLen)
 {
-    uint8_t tmp;
-    ReturnCode err = ERR_NONE;
-    uint16_t a;
-    uint8_t* outbuf = outbuffer;
-
     *outBufLen = 0;
 
     if (maxOutBufLen < 64U) {
         return ERR_NOMEM;
     }
 
-    tmp = data;
-    for (a = 0; a < 64U; a++)
-    {
-        switch (tmp)
-        {
-            case 0:
-                *outbuf = ISO15693_DAT_SLOT0_1_256;
-                break;
-            case 1:
-                *outbuf = ISO15693_DAT_SLOT1_1_256;
-                break;
-            case 2:
-                *outbuf = ISO15693_DAT_SLOT2_1_256;
-                break;
-            case 3:
-                *outbuf = ISO15693_DAT_SLOT3_1_256;
-                break;
-            default:
-                *outbuf = 0;
-                break;               
-        }
-        outbuf++;
-        (*outBufLen)++;
-        tmp -= 4U;     /*  PRQA S 2911 # CERT INT30 - Intentional underflow, part of the coding */
-    }
+    /* Only the output byte holding the data slot is modulated, 4 slots per byte */
+    ST_MEMSET(outbuffer, 0, 64U);
+    outbuffer[data >> 2U] = gIso15693Code1Of256Slot[data & 0x3U];
+    *outBufLen = 64U;
 
-    return err;
+    return ERR_NONE;
 }
 
 #endif /* RFAL_FEATURE_NFCV */
@@ -531,7 +531,7 @@ ReturnCode rfalNfcbPollerGetCollisionResolutionStatus( void )
                             rfalNfcbPollerSleepTx( gRfalNfcb.CR.nfcbDevList[(*gRfalNfcb.CR.devCnt) - (uint8_t)1U].sensbRes.nfcid0 );
                             gRfalNfcb.CR.nfcbDevList[(*gRfalNfcb.CR.devCnt) - (uint8_t)1U].isSleep = true;
                             
-                            gRfalNfcb.CR.tmr = platformTimerCreate( (uint16_t)rfalConv1fcToMs(RFAL_NFCB_ACTIVATION_FWT) );
+                            gRfalNfcb.CR.tmr = platformTimerCreate1fc( RFAL_NFCB_ACTIVATION_FWT );
                             ret = ERR_BUSY;
                         }
                         
@@ -605,7 +605,7 @@ ReturnCode rfalNfcbPollerGetCollisionResolutionStatus( void )
                 rfalNfcbPollerSleepTx( gRfalNfcb.CR.nfcbDevList[((*gRfalNfcb.CR.devCnt) - (uint8_t)1U)].sensbRes.nfcid0 );
                 gRfalNfcb.CR.nfcbDevList[((*gRfalNfcb.CR.devCnt) - (uint8_t)1U)].isSleep = true;
                 
-                gRfalNfcb.CR.tmr = platformTimerCreate( (uint16_t) rfalConv1fcToMs(RFAL_NFCB_ACTIVATION_FWT) );
+                gRfalNfcb.CR.tmr = platformTimerCreate1fc( RFAL_NFCB_ACTIVATION_FWT );
             }
             
             /* Activity 2.1  9.3.5.6  -  Symbol 5 */
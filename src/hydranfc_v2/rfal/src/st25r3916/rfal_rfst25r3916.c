@@ -411,6 +411,7 @@ typedef union{  /*  PRQA S 0750 # MISRA 19.2 - Both members are of the same type
 #define rfalCalcNumBytes( nBits )                (((uint32_t)(nBits) + 7U) / 8U)                                   /*!< Returns the number of bytes required to fit given the number of bits */
 
 #define rfalTimerStart( timer, time_ms )         do{ platformTimerDestroy( timer ); (timer) = platformTimerCreate((uint16_t)(time_ms)); } while(0) /*!< Configures and starts timer         */
+#define rfalTimerStart1fc( timer, time_1fc )     do{ platformTimerDestroy( timer ); (timer) = platformTimerCreate1fc((time_1fc)); } while(0)       /*!< Configures and starts timer in 1/fc units */
 #define rfalTimerisExpired( timer )              platformTimerIsExpired( timer )                                    /*!< Checks if timer has expired                                         */
 #define rfalTimerDestroy( timer )                platformTimerDestroy( timer )                                      /*!< Destroys timer                                                      */
 
@@ -1245,7 +1246,7 @@ ReturnCode rfalFieldOnAndStartGT( void )
     if( (gRFAL.timings.GT != RFAL_TIMING_NONE) )
     {
         /* Ensure that a SW timer doesn't have a lower value then the minimum  */
-        rfalTimerStart( gRFAL.tmr.GT, rfalConv1fcToMs( MAX( (gRFAL.timings.GT), RFAL_ST25R3916_GT_MIN_1FC) ) );
+        rfalTimerStart1fc( gRFAL.tmr.GT, MAX( (gRFAL.timings.GT), RFAL_ST25R3916_GT_MIN_1FC) );
     }
     
     return ret;
@@ -2127,7 +2128,7 @@ static void rfalTransceiveTx( void )
             {
                 /* Load FIFO with the remaining length or maximum available */
                 tmp = MIN( (gRFAL.fifo.bytesTotal - gRFAL.fifo.bytesWritten), gRFAL.fifo.expWL);       /* tmp holds the number of bytes written on this iteration */
-                st25r3916WriteFifo( &gRFAL.TxRx.ctx.txBuf[gRFAL.fifo.bytesWritten], tmp );
+                st25r3916WriteFifoStart( &gRFAL.TxRx.ctx.txBuf[gRFAL.fifo.bytesWritten], tmp );        /* streamed from txBuf while waiting for next WL           */
             }
             
             /* Update total written bytes to FIFO */
@@ -2611,7 +2612,8 @@ static void rfalTransceiveRx( void )
             
             /*******************************************************************************/
             /* Retrieve incoming bytes from FIFO to rxBuf, and store already read amount   */
-            st25r3916ReadFifo( &gRFAL.TxRx.ctx.rxBuf[gRFAL.fifo.bytesWritten], aux);
+            /* Streamed to rxBuf in background, next ST25R3916 access waits for its end    */
+            st25r3916ReadFifoStart( &gRFAL.TxRx.ctx.rxBuf[gRFAL.fifo.bytesWritten], aux);
             gRFAL.fifo.bytesWritten += aux;
             
             /*******************************************************************************/
@@ -2619,7 +2621,7 @@ static void rfalTransceiveRx( void )
              * FIFO so that ST25R391x can continue with reception                          */
             if( aux < tmp )
             {
-                st25r3916ReadFifo( NULL, (tmp - aux) );
+                st25r3916ReadFifoStart( NULL, (tmp - aux) );
             }
             
             rfalFIFOStatusClear();
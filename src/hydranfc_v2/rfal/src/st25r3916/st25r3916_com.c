@@ -50,6 +50,9 @@
 */
 
 #define ST25R3916_OPTIMIZE              true                           /*!< Optimization switch: false always write value to register      */
+#define ST25R3916_SHADOW_REGS           true                           /*!< Optimization switch: false always read registers over SPI      */
+#define ST25R3916_SHADOW_LEN            128U                           /*!< Space A and Space B registers                                  */
+#define ST25R3916_STREAM_MIN_LEN        16U                            /*!< Shorter FIFO transfers are not worth a background transfer     */
 #define ST25R3916_I2C_ADDR              (0xA0U >> 1)                   /*!< ST25R3916's default I2C address                                */
 #define ST25R3916_REG_LEN               1U                             /*!< Byte length of a ST25R3916 register                            */
 
@@ -84,6 +87,11 @@
 static uint8_t  comBuf[ST25R3916_BUF_LEN];                             /*!< ST25R3916 communication buffer                                 */
 static uint16_t comBufIt;                                              /*!< ST25R3916 communication buffer iterator                        */
 #endif /* ST25R_COM_SINGLETXRX */
+
+static uint8_t  shadowVal[ST25R3916_SHADOW_LEN];                      /*!< Last value written to/read from each register                 */
+static uint8_t  shadowValid[ST25R3916_SHADOW_LEN / 8U];               /*!< One bit per register, set when shadowVal is up to date         */
+static st25r3916ComStats comStats;                                     /*!< Communication counters                                         */
+static ReturnCode comErr;                                              /*!< First SPI error of the ongoing transaction                     */
     
 /*
  ******************************************************************************
@@ -107,9 +115,26 @@ static void st25r3916comStart( void );
  * 
  * This method performs the required actions to terminate communications with 
  * ST25R3916, either by SPI or I2C 
+ * 
+ * \return ERR_IO   : A transfer of this transaction failed
+ * \return ERR_NONE : No error
  ******************************************************************************
  */
-static void st25r3916comStop( void );
+static ReturnCode st25r3916comStop( void );
+
+/*!
+ ******************************************************************************
+ * \brief ST25R3916 communication transfer check
+ * 
+ * Records the first failed transfer of the ongoing transaction, returned
+ * by st25r3916comStop()
+ * 
+ * \param[in]   ok : false if the platform transfer failed
+ ******************************************************************************
+ */
+#ifndef RFAL_USE_I2C
+static void st25r3916comCheck( bool ok );
+#endif /* RFAL_USE_I2C */
 
 /*!
  ******************************************************************************
@@ -170,16 +195,138 @@ static void st25r3916comRx( uint8_t* rxBuf, uint16_t rxLen );
  */
 static void st25r3916comTxByte( uint8_t txByte, bool last, bool txOnly );
 
+/*!
+ ******************************************************************************
+ * \brief Check if a register can be shadowed
+ * 
+ * Only configuration registers that the ST25R3916 never changes on its own
+ * can be cached. Interrupt, status and display registers, as well as the
+ * Operation Control register (updated by field on commands), are always read.
+ * 
+ * \param[in]  reg : register address, Space-B flag included
+ *  
+ * \return true if the register can be shadowed
+ ******************************************************************************
+ */
+static bool st25r3916ShadowCacheable( uint8_t reg );
+
+/*!
+ ******************************************************************************
+ * \brief ST25R3916 communication Stream and Stop
+ * 
+ * This method transfers the FIFO data directly from/to the caller buffer in
+ * background and terminates the communication. Chip select is released at
+ * the end of the transfer, the next st25r3916comStart() waits for it.
+ * Falls back to a blocking transfer when background transfers are not
+ * available.
+ * 
+ * \param[in]   txBuf : the buffer to transmit, or NULL when receiving
+ * \param[out]  rxBuf : the buffer to receive in, or NULL to discard
+ * \param[in]   len   : the length to transfer
+ *  
+ * \return ERR_IO   : The blocking transfer failed
+ * \return ERR_NONE : No error, or background transfer started
+ ******************************************************************************
+ */
+static ReturnCode st25r3916comStreamStop( const uint8_t* txBuf, uint8_t* rxBuf, uint16_t len );
+
 
 /*
  ******************************************************************************
  * LOCAL FUNCTION
  ******************************************************************************
  */
+static bool st25r3916ShadowCacheable( uint8_t reg )
+{
+    if( !ST25R3916_SHADOW_REGS || (reg >= ST25R3916_SHADOW_LEN) )
+    {
+        return false;
+    }
+    
+    if( (reg & ST25R3916_SPACE_B) != 0U )
+    {
+        return ( (reg != ST25R3916_REG_TX_DRIVER_STATUS) && (reg != ST25R3916_REG_REGULATOR_RESULT) );
+    }
+    
+    switch( reg )
+    {
+        case ST25R3916_REG_OP_CONTROL:
+        case ST25R3916_REG_NFCIP1_BIT_RATE:
+        case ST25R3916_REG_AD_RESULT:
+        case ST25R3916_REG_RSSI_RESULT:
+        case ST25R3916_REG_GAIN_RED_STATE:
+        case ST25R3916_REG_CAP_SENSOR_RESULT:
+        case ST25R3916_REG_AUX_DISPLAY:
+        case ST25R3916_REG_AMPLITUDE_MEASURE_AA_RESULT:
+        case ST25R3916_REG_AMPLITUDE_MEASURE_RESULT:
+        case ST25R3916_REG_PHASE_MEASURE_AA_RESULT:
+        case ST25R3916_REG_PHASE_MEASURE_RESULT:
+        case ST25R3916_REG_CAPACITANCE_MEASURE_AA_RESULT:
+        case ST25R3916_REG_CAPACITANCE_MEASURE_RESULT:
+        case ST25R3916_REG_IC_IDENTITY:
+            return false;
+            
+        default:
+            /* IRQ, FIFO and collision status registers */
+            return ( (reg < ST25R3916_REG_IRQ_MAIN) || (reg > ST25R3916_REG_PASSIVE_TARGET_STATUS) );
+    }
+}
+
+
+/*******************************************************************************/
+static void st25r3916ShadowUpdate( uint8_t reg, const uint8_t* values, uint8_t length )
+{
+    uint8_t i;
+    uint8_t r;
+    
+    for( i = 0; i < length; i++ )
+    {
+        r = (uint8_t)(reg + i);
+        if( st25r3916ShadowCacheable( r ) )
+        {
+            shadowVal[r] = values[i];
+            shadowValid[r >> 3] |= (uint8_t)(1U << (r & 7U));
+        }
+    }
+}
+
+
+/*******************************************************************************/
+static bool st25r3916ShadowRead( uint8_t reg, uint8_t* values, uint8_t length )
+{
+    uint8_t i;
+    uint8_t r;
+    
+    for( i = 0; i < length; i++ )
+    {
+        r = (uint8_t)(reg + i);
+        if( !st25r3916ShadowCacheable( r ) || ((shadowValid[r >> 3] & (1U << (r & 7U))) == 0U) )
+        {
+            return false;
+        }
+    }
+    
+    ST_MEMCPY( values, &shadowVal[reg], length );
+    comStats.shadowHits++;
+    return true;
+}
+
+
+/*******************************************************************************/
 static void st25r3916comStart( void )
 {
     /* Make this operation atomic, disabling ST25R3916 interrupt during communications*/
     platformProtectST25RComm();
+    comStats.transactions++;
+    comErr = ERR_NONE;
+    
+#if !defined(RFAL_USE_I2C) && defined(platformSpiTxRxWait)
+    /* A FIFO stream may still be running, an aborted one leaves CS asserted */
+    if( platformSpiTxRxWait() != HAL_OK )
+    {
+        platformSpiDeselect();
+    }
+#endif /* platformSpiTxRxWait */
     
 #ifdef RFAL_USE_I2C
     /* I2C Start and send Slave Address */
@@ -199,8 +346,10 @@ static void st25r3916comStart( void )
 
 
 /*******************************************************************************/
-static void st25r3916comStop( void )
+static ReturnCode st25r3916comStop( void )
 {
+    ReturnCode ret;
+    
 #ifdef RFAL_USE_I2C
     /* Generate Stop signal */
     st25r3916I2CStop();
@@ -209,11 +358,29 @@ static void st25r3916comStop( void )
     platformSpiDeselect();
 #endif /* RFAL_USE_I2C */
     
+    /* Read the transaction error before another thread can start one */
+    ret = comErr;
+    
     /* reEnable the ST25R3916 interrupt */
     platformUnprotectST25RComm();
+    
+    return ret;
 }
 
 
+/*******************************************************************************/
+#ifndef RFAL_USE_I2C
+static void st25r3916comCheck( bool ok )
+{
+    if( !ok && (comErr == ERR_NONE) )
+    {
+        comErr = ERR_IO;
+        comStats.errors++;
+    }
+}
+#endif /* RFAL_USE_I2C */
+
+
 /*******************************************************************************/
 #ifdef RFAL_USE_I2C
 static void st25r3916comRepeatStart( void )
@@ -232,6 +399,7 @@ static void st25r3916comTx( const uint8_t* txBuf, uint16_t txLen, bool last, boo
     
     if( txLen > 0U )
     {
+        comStats.bytes += txLen;
 #ifdef RFAL_USE_I2C
         platformI2CTx( txBuf, txLen, last, txOnly );
 #else /* RFAL_USE_I2C */
@@ -243,11 +411,11 @@ static void st25r3916comTx( const uint8_t* txBuf, uint16_t txLen, bool last, boo
                 
             if( last && txOnly )                                                                    /* only perform SPI transaction if no Rx will follow */
             {
-                platformSpiTxRx( comBuf, NULL, comBufIt );
+                st25r3916comCheck( platformSpiTxRx( comBuf, NULL, comBufIt ) == HAL_OK );
             }
             
         #else
-            platformSpiTxRx( txBuf, NULL, txLen );
+            st25r3916comCheck( platformSpiTxRx( txBuf, NULL, txLen ) == HAL_OK );
         #endif /* ST25R_COM_SINGLETXRX */
             
 #endif /* RFAL_USE_I2C */
@@ -260,26 +428,63 @@ static void st25r3916comRx( uint8_t* rxBuf, uint16_t rxLen )
 {
     if( rxLen > 0U )
     {
+        comStats.bytes += rxLen;
 #ifdef RFAL_USE_I2C
         platformI2CRx( rxBuf, rxLen );
 #else /* RFAL_USE_I2C */
         
     #ifdef ST25R_COM_SINGLETXRX
         ST_MEMSET( &comBuf[comBufIt], 0x00, MIN( rxLen, (ST25R3916_BUF_LEN - comBufIt) ) );     /* clear outgoing buffer                                  */
-        platformSpiTxRx( comBuf, comBuf, MIN( (comBufIt + rxLen), ST25R3916_BUF_LEN ) );        /* transceive as a single SPI call                        */
+        st25r3916comCheck( platformSpiTxRx( comBuf, comBuf, MIN( (comBufIt + rxLen), ST25R3916_BUF_LEN ) ) == HAL_OK ); /* transceive as a single SPI call */
         ST_MEMCPY( rxBuf, &comBuf[comBufIt], MIN( rxLen, (ST25R3916_BUF_LEN - comBufIt) ) );    /* copy from local buf to output buffer and skip cmd byte */
     #else
-        if( rxBuf != NULL)
-        {
-            ST_MEMSET( rxBuf, 0x00, rxLen );                                                    /* clear outgoing buffer                                  */
-        }
-        platformSpiTxRx( NULL, rxBuf, rxLen );
+        st25r3916comCheck( platformSpiTxRx( NULL, rxBuf, rxLen ) == HAL_OK );                   /* NULL tx sends 0x00, no need to clear rxBuf             */
     #endif /* ST25R_COM_SINGLETXRX */
 #endif /* RFAL_USE_I2C */
     }
 }
 
 
+/*******************************************************************************/
+#if !defined(RFAL_USE_I2C) && defined(platformSpiTxRxStart)
+static void st25r3916comStreamDone( void *param )
+{
+    NO_WARNING(param);
+    platformSpiDeselect();
+}
+#endif /* platformSpiTxRxStart */
+
+
+/*******************************************************************************/
+static ReturnCode st25r3916comStreamStop( const uint8_t* txBuf, uint8_t* rxBuf, uint16_t len )
+{
+#if !defined(RFAL_USE_I2C) && defined(platformSpiTxRxStart)
+    if( len >= ST25R3916_STREAM_MIN_LEN )
+    {
+        if( platformSpiTxRxStart( txBuf, rxBuf, len, st25r3916comStreamDone ) == HAL_OK )
+        {
+            comStats.bytes += len;
+            comStats.streams++;
+            
+            /* Chip select released by st25r3916comStreamDone() */
+            platformUnprotectST25RComm();
+            return ERR_NONE;
+        }
+    }
+#endif /* platformSpiTxRxStart */
+    
+    if( txBuf != NULL )
+    {
+        st25r3916comTx( txBuf, len, true, true );
+    }
+    else
+    {
+        st25r3916comRx( rxBuf, len );
+    }
+    return st25r3916comStop();
+}
+
+
 /*******************************************************************************/
 static void st25r3916comTxByte( uint8_t txByte, bool last, bool txOnly )
 {
@@ -305,6 +510,15 @@ ReturnCode st25r3916ReadMultipleRegisters( uint8_t reg, uint8_t* values, uint8_t
 {
     if( length > 0U )
     {
+        /* Configuration registers do not need an SPI access once known */
+        platformProtectST25RComm();
+        if( st25r3916ShadowRead( reg, values, length ) )
+        {
+            platformUnprotectST25RComm();
+            return ERR_NONE;
+        }
+        platformUnprotectST25RComm();
+        
         st25r3916comStart();
         
         /* If is a space-B register send a direct command first */
@@ -316,7 +530,13 @@ ReturnCode st25r3916ReadMultipleRegisters( uint8_t reg, uint8_t* values, uint8_t
         st25r3916comTxByte( ((reg & ~ST25R3916_SPACE_B) | ST25R3916_READ_MODE), true, false );
         st25r3916comRepeatStart();
         st25r3916comRx( values, length );
-        st25r3916comStop();
+        
+        /* Update the shadow while the registers cannot change under us */
+        if( comErr == ERR_NONE )
+        {
+            st25r3916ShadowUpdate( reg, values, length );
+        }
+        return st25r3916comStop();
     }
     
     return ERR_NONE;
@@ -334,6 +554,8 @@ ReturnCode st25r3916WriteRegister( uint8_t reg, uint8_t val )
 /*******************************************************************************/
 ReturnCode st25r3916WriteMultipleRegisters( uint8_t reg, const uint8_t* values, uint8_t length )
 {
+    ReturnCode ret;
+    
     if( length > 0U )
     {
         st25r3916comStart();
@@ -345,7 +567,17 @@ ReturnCode st25r3916WriteMultipleRegisters( uint8_t reg, const uint8_t* values,
         
         st25r3916comTxByte( ((reg & ~ST25R3916_SPACE_B) | ST25R3916_WRITE_MODE), false, true );
         st25r3916comTx( values, length, true, true );
-        st25r3916comStop();
+        
+        /* Registers are unknown after a failed write */
+        if( comErr == ERR_NONE )
+        {
+            st25r3916ShadowUpdate( reg, values, length );
+        }
+        else
+        {
+            ST_MEMSET( shadowValid, 0x00, sizeof(shadowValid) );
+        }
+        EXIT_ON_ERR( ret, st25r3916comStop() );
         
         /* Send a WriteMultiReg event to LED handling */
         st25r3916ledEvtWrMultiReg( reg, values, length);
@@ -368,7 +600,42 @@ ReturnCode st25r3916WriteFifo( const uint8_t* values, uint16_t length )
         st25r3916comStart();
         st25r3916comTxByte( ST25R3916_FIFO_LOAD, false, true );
         st25r3916comTx( values, length, true, true );
-        st25r3916comStop();
+        return st25r3916comStop();
+    }
+
+    return ERR_NONE;
+}
+
+
+/*******************************************************************************/
+ReturnCode st25r3916WriteFifoStart( const uint8_t* values, uint16_t length )
+{
+    if( length > ST25R3916_FIFO_DEPTH )
+    {
+        return ERR_PARAM;
+    }
+    
+    if( length > 0U )
+    {
+        st25r3916comStart();
+        st25r3916comTxByte( ST25R3916_FIFO_LOAD, false, true );
+        return st25r3916comStreamStop( values, NULL, length );
+    }
+
+    return ERR_NONE;
+}
+
+
+/*******************************************************************************/
+ReturnCode st25r3916ReadFifoStart( uint8_t* buf, uint16_t length )
+{
+    if( length > 0U )
+    {
+        st25r3916comStart();
+        st25r3916comTxByte( ST25R3916_FIFO_READ, true, false );
+        
+        st25r3916comRepeatStart();
+        return st25r3916comStreamStop( NULL, buf, length );
     }
 
     return ERR_NONE;
@@ -385,7 +652,7 @@ ReturnCode st25r3916ReadFifo( uint8_t* buf, uint16_t length )
         
         st25r3916comRepeatStart();
         st25r3916comRx( buf, length );
-        st25r3916comStop();
+        return st25r3916comStop();
     }
 
     return ERR_NONE;
@@ -405,7 +672,7 @@ ReturnCode st25r3916WritePTMem( const uint8_t* values, uint16_t length )
         st25r3916comStart();
         st25r3916comTxByte( ST25R3916_PT_A_CONFIG_LOAD, false, true );
         st25r3916comTx( values, length, true, true );
-        st25r3916comStop();
+        return st25r3916comStop();
     }
 
     return ERR_NONE;
@@ -416,6 +683,7 @@ ReturnCode st25r3916WritePTMem( const uint8_t* values, uint16_t length )
 ReturnCode st25r3916ReadPTMem( uint8_t* values, uint16_t length )
 {
     uint8_t tmp[ST25R3916_REG_LEN + ST25R3916_PTM_LEN];  /* local buffer to handle prepended byte on I2C and SPI */
+    ReturnCode ret;
     
     if( length > 0U )
     {
@@ -429,7 +697,7 @@ ReturnCode st25r3916ReadPTMem( uint8_t* values, uint16_t length )
         
         st25r3916comRepeatStart();
         st25r3916comRx( tmp, (ST25R3916_REG_LEN + length) );  /* skip prepended byte */
-        st25r3916comStop();
+        EXIT_ON_ERR( ret, st25r3916comStop() );
         
         /* Copy PTMem content without prepended byte */
         ST_MEMCPY( values, (tmp+ST25R3916_REG_LEN), length );
@@ -452,7 +720,7 @@ ReturnCode st25r3916WritePTMemF( const uint8_t* values, uint16_t length )
         st25r3916comStart();
         st25r3916comTxByte( ST25R3916_PT_F_CONFIG_LOAD, false, true );
         st25r3916comTx( values, length, true, true );
-        st25r3916comStop();
+        return st25r3916comStop();
     }
 
     return ERR_NONE;
@@ -472,7 +740,7 @@ ReturnCode st25r3916WritePTMemTSN( const uint8_t* values, uint16_t length )
         st25r3916comStart();
         st25r3916comTxByte( ST25R3916_PT_TSN_DATA_LOAD, false, true );
         st25r3916comTx( values, length, true, true );
-        st25r3916comStop();
+        return st25r3916comStop();
     }
 
     return ERR_NONE;
@@ -482,9 +750,17 @@ ReturnCode st25r3916WritePTMemTSN( const uint8_t* values, uint16_t length )
 /*******************************************************************************/
 ReturnCode st25r3916ExecuteCommand( uint8_t cmd )
 {
+    ReturnCode ret;
+    
     st25r3916comStart();
     st25r3916comTxByte( (cmd | ST25R3916_CMD_MODE ), true, true );
-    st25r3916comStop();
+    
+    /* All registers are back to their default value */
+    if( cmd == ST25R3916_CMD_SET_DEFAULT )
+    {
+        st25r3916ShadowInvalidate();
+    }
+    EXIT_ON_ERR( ret, st25r3916comStop() );
     
     /* Send a cmd event to LED handling */
     st25r3916ledEvtCmd(cmd);
@@ -501,9 +777,8 @@ ReturnCode st25r3916ReadTestRegister( uint8_t reg, uint8_t* val )
     st25r3916comTxByte( (reg | ST25R3916_READ_MODE), true, false );
     st25r3916comRepeatStart();
     st25r3916comRx( val, ST25R3916_REG_LEN );
-    st25r3916comStop();
     
-    return ERR_NONE;
+    return st25r3916comStop();
 }
 
 
@@ -516,9 +791,8 @@ ReturnCode st25r3916WriteTestRegister( uint8_t reg, uint8_t val )
     st25r3916comTxByte( ST25R3916_CMD_TEST_ACCESS, false, true );
     st25r3916comTxByte( (reg | ST25R3916_WRITE_MODE), false, true );
     st25r3916comTx( &value, ST25R3916_REG_LEN, true, true );
-    st25r3916comStop();
     
-    return ERR_NONE;
+    return st25r3916comStop();
 }
 
 
@@ -631,6 +905,29 @@ bool st25r3916CheckReg( uint8_t reg, uint8_t mask, uint8_t val )
 }
 
 
+/*******************************************************************************/
+void st25r3916ShadowInvalidate( void )
+{
+    platformProtectST25RComm();
+    ST_MEMSET( shadowValid, 0x00, sizeof(shadowValid) );
+    platformUnprotectST25RComm();
+}
+
+
+/*******************************************************************************/
+void st25r3916GetComStats( st25r3916ComStats *stats )
+{
+    *stats = comStats;
+}
+
+
+/*******************************************************************************/
+void st25r3916ResetComStats( void )
+{
+    ST_MEMSET( &comStats, 0x00, sizeof(comStats) );
+}
+
+
 /*******************************************************************************/
 bool st25r3916IsRegValid( uint8_t reg )
 {
@@ -962,6 +962,22 @@
 
 /*! \endcond DOXYGEN_SUPRESS */
 
+/*
+******************************************************************************
+* GLOBAL TYPES
+******************************************************************************
+*/
+
+/*! ST25R3916 communication counters */
+typedef struct
+{
+    uint32_t transactions;   /*!< Number of SPI transactions (chip select cycles) */
+    uint32_t bytes;          /*!< Number of bytes exchanged, commands included    */
+    uint32_t shadowHits;     /*!< Register reads served by the shadow cache       */
+    uint32_t streams;        /*!< FIFO transfers done in background               */
+    uint32_t errors;         /*!< Transactions with a failed SPI transfer         */
+} st25r3916ComStats;
+
 /*
 ******************************************************************************
 * GLOBAL FUNCTION PROTOTYPES
@@ -1075,6 +1091,41 @@ ReturnCode st25r3916WriteFifo( const uint8_t* values, uint16_t length );
  */
 ReturnCode st25r3916ReadFifo( uint8_t* buf, uint16_t length );
 
+/*! 
+ *****************************************************************************
+ *  \brief  Start writing values to ST25R3916 FIFO
+ *
+ *  Same as st25r3916WriteFifo() but the data is streamed from \a values in
+ *  background. \a values shall stay valid until the next ST25R3916 access,
+ *  which waits for the end of the transfer.
+ *
+ *  \param[in]  values: pointer to a buffer containing the values to be written
+ *                      to the FIFO.
+ *  \param[in]  length: Number of values to be written.
+ *
+ *  \return ERR_NONE  : Operation successful
+ *  \return ERR_PARAM : Invalid parameter
+ *****************************************************************************
+ */
+ReturnCode st25r3916WriteFifoStart( const uint8_t* values, uint16_t length );
+
+/*! 
+ *****************************************************************************
+ *  \brief  Start reading values from ST25R3916 FIFO
+ *
+ *  Same as st25r3916ReadFifo() but the data is streamed to \a buf in
+ *  background. \a buf content is valid after the next ST25R3916 access,
+ *  which waits for the end of the transfer.
+ *
+ *  \param[out]  buf: pointer to a buffer where the FIFO content shall be
+ *                       written to, NULL to discard it.
+ *  \param[in]  length: Number of bytes to read.
+ *
+ *  \return ERR_NONE  : Operation successful
+ *****************************************************************************
+ */
+ReturnCode st25r3916ReadFifoStart( uint8_t* buf, uint16_t length );
+
 /*! 
  *****************************************************************************
  *  \brief  Writes values to ST25R3916 PTM
@@ -1310,6 +1361,37 @@ bool st25r3916CheckReg( uint8_t reg, uint8_t mask, uint8_t val );
  */
 bool st25r3916IsRegValid( uint8_t reg );
 
+/*! 
+ *****************************************************************************
+ *  \brief  Invalidate the register shadow cache
+ *
+ *  Configuration registers are cached on write and read back from the cache.
+ *  This function shall be called whenever the ST25R3916 registers may have
+ *  changed without going through this module (chip reset, power cycle).
+ *  Set Default command invalidates the cache automatically.
+ *
+ *****************************************************************************
+ */
+void st25r3916ShadowInvalidate( void );
+
+/*! 
+ *****************************************************************************
+ *  \brief  Get communication counters
+ *
+ *  \param[out]  stats: counters since last st25r3916ResetComStats()
+ *
+ *****************************************************************************
+ */
+void st25r3916GetComStats( st25r3916ComStats *stats );
+
+/*! 
+ *****************************************************************************
+ *  \brief  Reset communication counters
+ *
+ *****************************************************************************
+ */
+void st25r3916ResetComStats( void );
+
 #endif /* ST25R3916_COM_H */
 
 
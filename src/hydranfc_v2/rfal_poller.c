@@ -47,6 +47,7 @@
 #include "bsp_uart.h"
 
 #include "rfal_poller.h"
+#include "hydranfc_v2.h"
 
 /*
 // tag content
@@ -73,6 +74,11 @@
 #define RFAL_POLLER_FOUND_V      0x08  /* NFC-V device Flag           */
 #define RFAL_POLLER_FOUND_ST25TB 0x10  /* ST25TB device found flag */
 
+#define RFAL_POLLER_WAKEUP_WAIT_US 10000 /* Max sleep in wake-up mode between user input checks */
+#define RFAL_POLLER_FIELD_OFF_US   10000 /* Field off time between poll cycles, above the 5.1 ms tag reset time */
+#define RFAL_POLLER_WAKEUP_OFF_US  100000 /* Field off time before (re)starting wake-up mode */
+#define RFAL_POLLER_ANTICOL_GT_US  1000 /* Guard time before collision resolution, required for some NFC-V tags */
+
 /*
 ******************************************************************************
 * GLOBAL TYPES
@@ -184,6 +190,7 @@ static bool RfalPollerTechDetection(t_hydra_console *con, nfc_technology_t nfc_t
 static bool RfalPollerCollResolution(t_hydra_console *con);
 static bool RfalPollerDeactivate(void);
 static void RfalPollerRun(t_hydra_console *con, nfc_technology_t nfc_tech);
+static bool RfalPollerWait(t_hydra_console *con, uint32_t timer);
 static nfc_card_type_t detect_nfc_card_type(t_hydra_console *con, uint8_t* uid, uint8_t uid_len, uint16_t atqa, uint8_t sak);
 /*
 void cprintf(t_hydra_console *con, const char *fmt, ...)
@@ -909,6 +916,31 @@ void ScanTags(t_hydra_console *con, nfc_technology_t nfc_tech)
 	RfalPollerRun(con, nfc_tech);
 }
 
+/*!
+ ******************************************************************************
+ * \brief Passive Poller Wait
+ *
+ * Sleeps until the given timer expires. The thread is woken by the ST25R3916
+ * IRQ or the next RFAL timer expiry to run rfalWorker() and check user input
+ * instead of spinning.
+ *
+ * \return true if the user asked to exit
+ ******************************************************************************
+ */
+static bool RfalPollerWait(t_hydra_console *con, uint32_t timer)
+{
+	int32_t remaining;
+
+	while((remaining = (int32_t)(timer - platformGetSysTickUs())) > 0) {
+		if(manageInput(con)) {
+			return true;
+		}
+		rfalWorker();
+		hydranfc_v2_worker_wait((uint32_t)remaining);
+	}
+	return false;
+}
+
 /*!
  ******************************************************************************
  * \brief Passive Poller Run
@@ -921,6 +953,8 @@ void ScanTags(t_hydra_console *con, nfc_technology_t nfc_tech)
  */
 static void RfalPollerRun(t_hydra_console *con, nfc_technology_t nfc_tech)
 {
+	hydranfc_v2_prof_mark_t prof_mark;
+
 	/* Initialize RFAL */
 	platformLog("\n\r RFAL Poller started \r\n");
 	//cprintf(con, "\n\r RFAL Poller started \r\n");
@@ -933,7 +967,8 @@ static void RfalPollerRun(t_hydra_console *con, nfc_technology_t nfc_tech)
 				if(manageInput(con)) {
 					return;
 				}
-				// still sleeping, don't do nothing...
+				// still sleeping, wait for the wake-up IRQ
+				hydranfc_v2_worker_wait(RFAL_POLLER_WAKEUP_WAIT_US);
 				continue;
 			}
 			// exit wake up mode
@@ -954,7 +989,12 @@ static void RfalPollerRun(t_hydra_console *con, nfc_technology_t nfc_tech)
 		}
 		/*******************************************************************************/
 		case RFAL_POLLER_STATE_TECHDETECT: {
-			if( !RfalPollerTechDetection(con, nfc_tech) ) { /* Poll for nearby devices in different technologies */
+			bool found;
+
+			hydranfc_v2_prof_start(&prof_mark);
+			found = RfalPollerTechDetection(con, nfc_tech); /* Poll for nearby devices in different technologies */
+			hydranfc_v2_prof_stop(HYDRANFC_V2_PROF_POLL, &prof_mark);
+			if( !found ) {
 				gState = RFAL_POLLER_STATE_DEACTIVATION; /* If no device was found, restart loop */
 				break;
 			}
@@ -974,12 +1014,18 @@ static void RfalPollerRun(t_hydra_console *con, nfc_technology_t nfc_tech)
 				instructionsDisplayed = false;
 			}
 
-			// add delay to avoid NFC-V Anticol frames back to back
-			HAL_Delay(1); /* Wait 1ms required for some Tags */
+			// add delay to avoid NFC-V Anticol frames back to back, sleeping
+			if(RfalPollerWait(con, platformTimerCreateUs(RFAL_POLLER_ANTICOL_GT_US))) {
+				gState = RFAL_POLLER_STATE_DEACTIVATION; /* Field is on, turn it off on next run */
+				return;
+			}
+			hydranfc_v2_prof_start(&prof_mark);
 			if( !RfalPollerCollResolution(con) ) { /* Resolve any eventual collision */
+				hydranfc_v2_prof_stop(HYDRANFC_V2_PROF_ANTICOL, &prof_mark);
 				gState = RFAL_POLLER_STATE_DEACTIVATION;	/* If Collision Resolution was unable to retrieve any device, restart loop */
 				break;
 			}
+			hydranfc_v2_prof_stop(HYDRANFC_V2_PROF_ANTICOL, &prof_mark);
 
 			platformLog("Device(s) found: %d \r\n", gDevCnt);
 			//cprintf(con, "Device(s) found: %d\r\n", gDevCnt);
@@ -1001,21 +1047,17 @@ static void RfalPollerRun(t_hydra_console *con, nfc_technology_t nfc_tech)
 			}
 			RfalPollerDeactivate();	/* If a card has been activated, properly deactivate the device */
 			rfalFieldOff();	/* Turn the Field Off powering down any device nearby */
-			/*
-			for(delay = 0; delay < 100; delay++)
-			{
-				if(manageInput(con))
-				{
-					return;
-				}
-				platformDelay(1); // Remain a certain period with field off
+			/* Remain a certain period with field off */
+			if(RfalPollerWait(con, platformTimerCreateUs(RFAL_POLLER_FIELD_OFF_US))) {
+				return;
 			}
-			*/
 			if( (detectMode == DETECT_MODE_AWAKEN) && (gDevCnt == 0) ) {
 				// no more tags, restart wakeup mode
 				detectMode = DETECT_MODE_WAKEUP;
 				rfalFieldOff();	/* Turns the Field On and starts GT timer */
-				HAL_Delay(100);
+				if(RfalPollerWait(con, platformTimerCreateUs(RFAL_POLLER_WAKEUP_OFF_US))) {
+					return;
+				}
 				rfalWakeUpModeStart(NULL);
 				setRadio(con);
 			}
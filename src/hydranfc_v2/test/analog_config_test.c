@@ -0,0 +1,261 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * rfalSetAnalogConfig() merges the Register-Mask-Value entries of a set
+ * into burst writes. Against the simulated chip, every Configuration ID
+ * of the table, then a table made of consecutive registers left unchanged,
+ * modified twice or back to their value, are applied both ways from the
+ * same register contents:
+ *  - merged, with rfalSetAnalogConfig() (first call and indexed call)
+ *  - one by one, with rfalChipChangeRegBits()/rfalChipChangeTestRegBits()
+ *    as the original ST implementation does.
+ * The register contents must end up the same, and the merged writes must
+ * only hit registers the one by one writes also modify.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "platform.h"
+#include "rfal_rf.h"
+#include "rfal_chip.h"
+#include "rfal_analogConfig.h"
+#include "st25r3916_com.h"
+#include "utils.h"
+
+#define TBL_MAX		4096
+#define TEST_REG	0x0080U		/* Test register flag of the table addresses */
+#define SYN_ID		0x7FFEU		/* Configuration ID not used by the table */
+#define ENTRY_LEN	sizeof(rfalAnalogConfigRegAddrMaskVal)
+#define HDR_LEN		(sizeof(rfalAnalogConfigId) + sizeof(rfalAnalogConfigNum))
+
+/* Registers written during an apply, per space */
+typedef struct {
+	bool written[ST25R3916_SIM_SPACE_NB][ST25R3916_SIM_REG_NB];
+	unsigned int writes;
+	unsigned long transactions;	/* SPI transactions, reads included */
+} write_log_t;
+
+static uint8_t tbl[TBL_MAX];
+static uint16_t tbl_len;
+static unsigned long ref_transactions, merged_transactions;
+
+static void log_write(void *ctx, uint8_t space, uint8_t reg, uint8_t val)
+{
+	write_log_t *log = ctx;
+
+	(void)val;
+	log->written[space][reg] = true;
+	log->writes++;
+}
+
+/* Original ST rfalSetAnalogConfig(): every set of the ID, entry by entry */
+static ReturnCode apply_one_by_one(rfalAnalogConfigId id)
+{
+	const uint8_t *e;
+	uint16_t off, addr;
+	uint8_t num, i;
+
+	for (off = 0; (off + HDR_LEN) <= tbl_len; off += (uint16_t)(HDR_LEN + (num * ENTRY_LEN))) {
+		num = tbl[off + sizeof(rfalAnalogConfigId)];
+		if (GETU16(&tbl[off]) != id)
+			continue;
+		for (i = 0; i < num; i++) {
+			e = &tbl[off + HDR_LEN + (i * ENTRY_LEN)];
+			addr = GETU16(e);
+			if ((addr & TEST_REG) != 0U)
+				rfalChipChangeTestRegBits((addr & ~TEST_REG), e[2], e[3]);
+			else
+				rfalChipChangeRegBits(addr, e[2], e[3]);
+		}
+	}
+	return ERR_NONE;
+}
+
+static ReturnCode apply(bool merged, rfalAnalogConfigId id, const st25r3916SimRegs *start,
+			st25r3916SimRegs *end, write_log_t *log)
+{
+	st25r3916ComStats com0, com1;
+	ReturnCode err;
+
+	st25r3916SimSetRegs(start);
+	st25r3916ShadowInvalidate();
+	memset(log, 0, sizeof(*log));
+	st25r3916GetComStats(&com0);
+	st25r3916SimSetWriteHook(log_write, log);
+	err = merged ? rfalSetAnalogConfig(id) : apply_one_by_one(id);
+	st25r3916SimSetWriteHook(NULL, NULL);
+	st25r3916GetComStats(&com1);
+	st25r3916SimGetRegs(end);
+	log->transactions = (unsigned long)(com1.transactions - com0.transactions);
+	return err;
+}
+
+static int check_id(rfalAnalogConfigId id, const st25r3916SimRegs *start, const char *call)
+{
+	static st25r3916SimRegs ref_regs, regs;
+	static write_log_t ref_log, log;
+	unsigned int s, r;
+	ReturnCode err;
+
+	apply(false, id, start, &ref_regs, &ref_log);
+	err = apply(true, id, start, &regs, &log);
+	if (err != ERR_NONE) {
+		printf("FAIL id 0x%04x (%s): error %d\n", (unsigned int)id, call, (int)err);
+		return 0;
+	}
+	for (s = 0; s < ST25R3916_SIM_SPACE_NB; s++) {
+		for (r = 0; r < ST25R3916_SIM_REG_NB; r++) {
+			if (regs.reg[s][r] != ref_regs.reg[s][r]) {
+				printf("FAIL id 0x%04x (%s): space %u reg 0x%02x = 0x%02x, expected 0x%02x\n",
+				       (unsigned int)id, call, s, r, regs.reg[s][r], ref_regs.reg[s][r]);
+				return 0;
+			}
+			if (log.written[s][r] && !ref_log.written[s][r]) {
+				printf("FAIL id 0x%04x (%s): space %u reg 0x%02x written, left as is one by one\n",
+				       (unsigned int)id, call, s, r);
+				return 0;
+			}
+		}
+	}
+	if (log.writes > ref_log.writes) {
+		printf("FAIL id 0x%04x (%s): %u register writes, %u one by one\n",
+		       (unsigned int)id, call, log.writes, ref_log.writes);
+		return 0;
+	}
+	ref_transactions += ref_log.transactions;
+	merged_transactions += log.transactions;
+	return 1;
+}
+
+/* Every Configuration ID of the table, on its first and indexed call */
+static int check_table(const char *name, unsigned int *ids)
+{
+	st25r3916SimRegs start;
+	uint16_t off, prev;
+	rfalAnalogConfigId id;
+	uint8_t num;
+	bool seen;
+
+	if (rfalAnalogConfigListReadRaw(tbl, sizeof(tbl), &tbl_len) != ERR_NONE) {
+		printf("FAIL %s: table not read\n", name);
+		return 0;
+	}
+	st25r3916SimGetRegs(&start);
+
+	*ids = 0;
+	ref_transactions = 0;
+	merged_transactions = 0;
+	for (off = 0; (off + HDR_LEN) <= tbl_len; off += (uint16_t)(HDR_LEN + (num * ENTRY_LEN))) {
+		num = tbl[off + sizeof(rfalAnalogConfigId)];
+		id = GETU16(&tbl[off]);
+		/* IDs with several sets are checked once */
+		seen = false;
+		for (prev = 0; prev < off; prev += (uint16_t)(HDR_LEN + (tbl[prev + sizeof(rfalAnalogConfigId)] * ENTRY_LEN)))
+			seen = seen || (GETU16(&tbl[prev]) == id);
+		if (seen)
+			continue;
+		if (!check_id(id, &start, "search") || !check_id(id, &start, "index"))
+			return 0;
+		(*ids)++;
+	}
+
+	st25r3916SimSetRegs(&start);
+	st25r3916ShadowInvalidate();
+	return 1;
+}
+
+static uint8_t *put_entry(uint8_t *p, uint16_t addr, uint8_t mask, uint8_t val)
+{
+	*p++ = (uint8_t)(addr >> 8);
+	*p++ = (uint8_t)addr;
+	*p++ = mask;
+	*p++ = val;
+	return p;
+}
+
+/* Runs of consecutive registers, some of them not modified by the set */
+static uint16_t make_table(uint8_t *buf)
+{
+	st25r3916SimRegs regs;
+	const uint8_t *a, *b;
+	uint8_t *p = buf;
+
+	st25r3916SimGetRegs(&regs);
+	a = regs.reg[ST25R3916_SIM_SPACE_A];
+	b = regs.reg[ST25R3916_SIM_SPACE_B];
+
+	*p++ = (uint8_t)(SYN_ID >> 8);
+	*p++ = (uint8_t)SYN_ID;
+	*p++ = 11;
+	p = put_entry(p, ST25R3916_REG_RX_CONF1, 0x0F, (uint8_t)~a[ST25R3916_REG_RX_CONF1]);     /* modified             */
+	p = put_entry(p, ST25R3916_REG_RX_CONF2, 0xFF, a[ST25R3916_REG_RX_CONF2]);               /* same value           */
+	p = put_entry(p, ST25R3916_REG_RX_CONF3, 0xF0, (uint8_t)~a[ST25R3916_REG_RX_CONF3]);     /* modified             */
+	p = put_entry(p, ST25R3916_REG_RX_CONF4, 0x00, 0xFF);                                      /* empty mask           */
+	p = put_entry(p, ST25R3916_REG_RX_CONF3, 0xF0, a[ST25R3916_REG_RX_CONF3]);               /* back to its value    */
+	p = put_entry(p, TEST_REG | 0x01U, 0x01, 0x01);                                            /* test register        */
+	p = put_entry(p, ST25R3916_REG_OVERSHOOT_CONF1, 0xFF, (uint8_t)(b[0x30] ^ 0x81U));         /* space B, modified    */
+	p = put_entry(p, ST25R3916_REG_OVERSHOOT_CONF2, 0xFF, b[0x31]);                           /* same value           */
+	p = put_entry(p, ST25R3916_REG_UNDERSHOOT_CONF1, 0xFF, b[0x32]);                          /* same value           */
+	p = put_entry(p, ST25R3916_REG_UNDERSHOOT_CONF2, 0x3C, (uint8_t)~b[0x33]);               /* modified             */
+	p = put_entry(p, ST25R3916_REG_OVERSHOOT_CONF2, 0x01, (uint8_t)~b[0x31]);                 /* run restarted        */
+
+	/* Second set of the same ID */
+	*p++ = (uint8_t)(SYN_ID >> 8);
+	*p++ = (uint8_t)SYN_ID;
+	*p++ = 6;
+	p = put_entry(p, ST25R3916_REG_ANT_TUNE_A, 0xFF, (uint8_t)(a[ST25R3916_REG_ANT_TUNE_A] + 1U));
+	p = put_entry(p, ST25R3916_REG_ANT_TUNE_B, 0xFF, a[ST25R3916_REG_ANT_TUNE_B]);
+	p = put_entry(p, ST25R3916_REG_TX_DRIVER, 0x00, 0x00);
+	p = put_entry(p, ST25R3916_REG_PT_MOD, 0xFF, (uint8_t)(a[ST25R3916_REG_PT_MOD] + 1U));
+	p = put_entry(p, ST25R3916_REG_FIELD_THRESHOLD_ACTV, 0xFF, a[ST25R3916_REG_FIELD_THRESHOLD_ACTV]);
+	p = put_entry(p, ST25R3916_REG_FIELD_THRESHOLD_DEACTV, 0x07, (uint8_t)~a[ST25R3916_REG_FIELD_THRESHOLD_DEACTV]);
+
+	return (uint16_t)(p - buf);
+}
+
+int main(void)
+{
+	static uint8_t syn[TBL_MAX];
+	unsigned int ids;
+	int ok = 1;
+
+	st25r3916SimReset();
+	rfalAnalogConfigInitialize();
+	if (rfalInitialize() != ERR_NONE) {
+		printf("FAIL rfalInitialize\n");
+		return 1;
+	}
+
+	if (check_table("default", &ids))
+		printf("default table: %u IDs ok, %lu SPI transactions merged, %lu one by one\n",
+		       ids, merged_transactions, ref_transactions);
+	else
+		ok = 0;
+
+	if ((rfalAnalogConfigListWriteRaw(syn, make_table(syn)) == ERR_NONE) && check_table("synthetic", &ids))
+		printf("synthetic table: %u IDs ok, %lu SPI transactions merged, %lu one by one\n",
+		       ids, merged_transactions, ref_transactions);
+	else
+		ok = 0;
+	rfalAnalogConfigInitialize();
+
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * rfalCrcCalculateCcitt() with every RFAL_CRC_METHOD against a bit by bit
+ * CRC-16 CCITT (reflected, polynomial 0x8408): every seed with every byte
+ * value, random buffers of all lengths at all 4 alignments, then the
+ * longest buffers a uint16_t length allows. The time per byte of each
+ * method is reported, it is only informative on the host.
+ *
+ * rfal_crc.c is built once per method, see the Makefile.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BUF_MAX		600
+#define RANDOM_RUNS	20000
+#define LONG_LEN	0xFFFFU
+#define BENCH_LEN	512U		/* Longest ST25R3916 FIFO transfer */
+#define BENCH_RUNS	20000
+
+uint16_t rfalCrcCalculateCcittBitwise(uint16_t preloadValue, const uint8_t *buf, uint16_t length);
+uint16_t rfalCrcCalculateCcittNibble(uint16_t preloadValue, const uint8_t *buf, uint16_t length);
+uint16_t rfalCrcCalculateCcittSlice4(uint16_t preloadValue, const uint8_t *buf, uint16_t length);
+
+typedef uint16_t (*crc_fn)(uint16_t preloadValue, const uint8_t *buf, uint16_t length);
+
+static const struct {
+	const char *name;
+	crc_fn fn;
+} methods[] = {
+	{ "bitwise", rfalCrcCalculateCcittBitwise },
+	{ "nibble", rfalCrcCalculateCcittNibble },
+	{ "slice4", rfalCrcCalculateCcittSlice4 },
+};
+
+static uint16_t crc_ref(uint16_t crc, const uint8_t *buf, uint16_t len)
+{
+	uint16_t i;
+	int b;
+
+	for (i = 0; i < len; i++) {
+		crc ^= buf[i];
+		for (b = 0; b < 8; b++)
+			crc = (crc & 1) ? ((crc >> 1) ^ 0x8408) : (crc >> 1);
+	}
+	return crc;
+}
+
+static uint8_t long_buf[LONG_LEN + 4U];
+
+static double bench_method(crc_fn fn)
+{
+	struct timespec t0, t1;
+	volatile uint16_t sink;
+	uint16_t crc = 0x6363;
+	int run;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (run = 0; run < BENCH_RUNS; run++)
+		crc = fn(crc, long_buf, BENCH_LEN);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	sink = crc;
+	(void)sink;
+
+	return (((double)(t1.tv_sec - t0.tv_sec) * 1e9) + (double)(t1.tv_nsec - t0.tv_nsec)) /
+	       ((double)BENCH_RUNS * BENCH_LEN);
+}
+
+static int check_method(const char *name, crc_fn fn)
+{
+	static uint8_t buf[BUF_MAX + 4];
+	uint32_t seed;
+	uint16_t len;
+	uint8_t off;
+	uint8_t byte;
+	int i, run;
+
+	for (seed = 0; seed <= 0xFFFF; seed++) {
+		for (i = 0; i < 256; i++) {
+			byte = (uint8_t)i;
+			if (fn((uint16_t)seed, &byte, 1) != crc_ref((uint16_t)seed, &byte, 1)) {
+				printf("FAIL %s: seed 0x%04x byte 0x%02x\n", name, (unsigned int)seed, (unsigned int)byte);
+				return 0;
+			}
+		}
+	}
+
+	srand(1);
+	for (run = 0; run < RANDOM_RUNS; run++) {
+		len = (uint16_t)(run % BUF_MAX);
+		off = (uint8_t)(run & 3);
+		seed = (uint32_t)rand() & 0xFFFF;
+		for (i = 0; i < len; i++)
+			buf[off + i] = (uint8_t)rand();
+		if (fn((uint16_t)seed, &buf[off], len) != crc_ref((uint16_t)seed, &buf[off], len)) {
+			printf("FAIL %s: seed 0x%04x, %u bytes at offset %u\n", name,
+			       (unsigned int)seed, (unsigned int)len, (unsigned int)off);
+			return 0;
+		}
+	}
+
+	/* Lengths close to the uint16_t limit, at all alignments */
+	for (i = 0; i < LONG_LEN + 4U; i++)
+		long_buf[i] = (uint8_t)rand();
+	for (run = 0; run < 16; run++) {
+		len = (uint16_t)(LONG_LEN - (run >> 2));
+		off = (uint8_t)(run & 3);
+		if (fn(0x6363, &long_buf[off], len) != crc_ref(0x6363, &long_buf[off], len)) {
+			printf("FAIL %s: %u bytes at offset %u\n", name,
+			       (unsigned int)len, (unsigned int)off);
+			return 0;
+		}
+	}
+
+	printf("%s: ok, %.2f ns/byte\n", name, bench_method(fn));
+	return 1;
+}
+
+int main(void)
+{
+	unsigned int i;
+	int ok = 1;
+
+	for (i = 0; i < (sizeof(methods) / sizeof(methods[0])); i++)
+		ok = check_method(methods[i].name, methods[i].fn) && ok;
+
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
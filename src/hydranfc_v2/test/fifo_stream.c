@@ -0,0 +1,148 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * FIFO water level handling of rfalTransceive() on the simulated chip.
+ *
+ * Frames longer than the 512 bytes FIFO are echoed by a selected tag:
+ * the transmission needs FIFO refills on FWL and the reception FIFO
+ * drains on FWL, both done by background SPI streams. The FIFO must
+ * never underflow or overflow and the echo must come back unchanged.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "platform.h"
+#include "rfal_rf.h"
+#include "rfal_analogConfig.h"
+#include "rfal_nfca.h"
+#include "st25r3916_com.h"
+
+#include "nfca_tag.h"
+
+#define FRAME_LEN	700
+#define FRAME_FWT	rfalConvMsTo1fc(10)
+
+static const uint8_t tag_uid[NFCA_TAG_UID_LEN] = { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+
+static uint8_t tx_buf[FRAME_LEN];
+static uint8_t rx_buf[FRAME_LEN + 16];
+
+static uint16_t echo_app(const uint8_t *rx, uint16_t rx_len, uint8_t *tx)
+{
+	memcpy(tx, rx, rx_len);
+	return rx_len;
+}
+
+static int check(ReturnCode err, const char *what)
+{
+	if (err != ERR_NONE) {
+		printf("FAIL %s: error %d\n", what, (int)err);
+		return 0;
+	}
+	return 1;
+}
+
+/* Echo a frame of the given length, checks the data and FIFO accounting */
+static int echo_frame(uint16_t len)
+{
+	st25r3916ComStats com0, com1;
+	st25r3916SimStats sim0, sim1;
+	uint16_t act_len = 0;
+	uint16_t i;
+	int ok = 1;
+
+	for (i = 0; i < len; i++)
+		tx_buf[i] = (uint8_t)((i * 7) + (len >> 3));
+	memset(rx_buf, 0, sizeof(rx_buf));
+
+	st25r3916GetComStats(&com0);
+	st25r3916SimGetStats(&sim0);
+	ok = check(rfalTransceiveBlockingTxRx(tx_buf, len, rx_buf, sizeof(rx_buf), &act_len,
+					      RFAL_TXRX_FLAGS_DEFAULT, FRAME_FWT), "rfalTransceiveBlockingTxRx");
+	st25r3916GetComStats(&com1);
+	st25r3916SimGetStats(&sim1);
+
+	if (ok && ((act_len != len) || (memcmp(rx_buf, tx_buf, len) != 0))) {
+		printf("FAIL %u bytes: %u bytes echoed, data %s\n", (unsigned int)len,
+		       (unsigned int)act_len, (memcmp(rx_buf, tx_buf, len) == 0) ? "ok" : "corrupted");
+		ok = 0;
+	}
+	if (sim1.fifoUnderflows != sim0.fifoUnderflows) {
+		printf("FAIL %u bytes: Tx FIFO underflow\n", (unsigned int)len);
+		ok = 0;
+	}
+	if (sim1.fifoOverflows != sim0.fifoOverflows) {
+		printf("FAIL %u bytes: Rx FIFO overflow\n", (unsigned int)len);
+		ok = 0;
+	}
+	/* Longer than the FIFO: both directions go through water levels and background streams */
+	if ((len > ST25R3916_SIM_FIFO_DEPTH) &&
+	    ((sim1.txWaterLevels == sim0.txWaterLevels) || (sim1.rxWaterLevels == sim0.rxWaterLevels) ||
+	     (com1.streams == com0.streams))) {
+		printf("FAIL %u bytes: %lu Tx FWL, %lu Rx FWL, %lu streams\n", (unsigned int)len,
+		       (unsigned long)(sim1.txWaterLevels - sim0.txWaterLevels),
+		       (unsigned long)(sim1.rxWaterLevels - sim0.rxWaterLevels),
+		       (unsigned long)(com1.streams - com0.streams));
+		ok = 0;
+	}
+
+	printf("%4u bytes: %s, %lu Tx FWL, %lu Rx FWL, %lu streams, fifo max %u\n", (unsigned int)len,
+	       ok ? "ok" : "FAIL",
+	       (unsigned long)(sim1.txWaterLevels - sim0.txWaterLevels),
+	       (unsigned long)(sim1.rxWaterLevels - sim0.rxWaterLevels),
+	       (unsigned long)(com1.streams - com0.streams), (unsigned int)sim1.fifoMax);
+	return ok;
+}
+
+int main(void)
+{
+	static const uint16_t lens[] = { 1, 16, 200, 300, 511, 512, 513, FRAME_LEN };
+	rfalNfcaListenDevice dev;
+	rfalNfcaSensRes sens_res;
+	nfca_tag_t tag;
+	uint8_t dev_cnt = 0;
+	unsigned int i;
+	int ok = 1;
+
+	st25r3916SimReset();
+	nfca_tag_init(&tag, tag_uid, sizeof(tag_uid), 0x00, echo_app);
+	st25r3916SimSetPeer(nfca_tag_peer, &tag);
+
+	rfalAnalogConfigInitialize();
+	ok = ok && check(rfalInitialize(), "rfalInitialize");
+	ok = ok && check(rfalNfcaPollerInitialize(), "rfalNfcaPollerInitialize");
+	ok = ok && check(rfalFieldOnAndStartGT(), "rfalFieldOnAndStartGT");
+	ok = ok && check(rfalNfcaPollerTechnologyDetection(RFAL_COMPLIANCE_MODE_NFC, &sens_res),
+			 "rfalNfcaPollerTechnologyDetection");
+	ok = ok && check(rfalNfcaPollerFullCollisionResolution(RFAL_COMPLIANCE_MODE_NFC, 1, &dev, &dev_cnt),
+			 "rfalNfcaPollerFullCollisionResolution");
+	if (ok && (dev_cnt != 1)) {
+		printf("FAIL %u device(s) found\n", (unsigned int)dev_cnt);
+		ok = 0;
+	}
+
+	for (i = 0; ok && (i < (sizeof(lens) / sizeof(lens[0]))); i++)
+		ok = echo_frame(lens[i]);
+
+	rfalFieldOff();
+
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host run of the RFAL and ST25R3916 driver against the simulated chip:
+ * initialization (self tests, oscillator, regulators), field on and
+ * NFC-A detection/collision resolution of one scripted tag.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "platform.h"
+#include "rfal_rf.h"
+#include "rfal_analogConfig.h"
+#include "rfal_nfca.h"
+#include "st25r3916_com.h"
+
+#include "nfca_tag.h"
+
+static const uint8_t tag_uid[NFCA_TAG_UID_LEN] = { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+
+static int check(ReturnCode err, const char *what)
+{
+	if (err != ERR_NONE) {
+		printf("FAIL %s: error %d\n", what, (int)err);
+		return 0;
+	}
+	return 1;
+}
+
+static void print_stats(void)
+{
+	st25r3916ComStats com;
+	st25r3916SimStats sim;
+
+	st25r3916GetComStats(&com);
+	st25r3916SimGetStats(&sim);
+
+	printf("com: %lu transactions, %lu bytes, %lu shadow hits, %lu streams, %lu errors\n",
+	       (unsigned long)com.transactions, (unsigned long)com.bytes,
+	       (unsigned long)com.shadowHits, (unsigned long)com.streams,
+	       (unsigned long)com.errors);
+	printf("sim: %lu irqs, %lu tx frames, %lu rx frames, fifo max %u, %lu underflows, %lu overflows\n",
+	       (unsigned long)sim.irqs, (unsigned long)sim.txFrames,
+	       (unsigned long)sim.rxFrames, (unsigned int)sim.fifoMax,
+	       (unsigned long)sim.fifoUnderflows, (unsigned long)sim.fifoOverflows);
+	printf("virtual time: %lu us\n", (unsigned long)((st25r3916SimGetTimeNs() - 1000000000ULL) / 1000U));
+}
+
+/* A failed SPI transfer is reported and does not leave a stale shadow */
+static int check_spi_error(void)
+{
+	st25r3916ComStats com0, com1;
+	uint8_t val;
+
+	st25r3916GetComStats(&com0);
+	st25r3916SimFailSpi(1);
+	if (st25r3916ReadRegister(ST25R3916_REG_FIFO_STATUS1, &val) != ERR_IO) {
+		printf("FAIL spi error: read not reported\n");
+		return 0;
+	}
+	st25r3916SimFailSpi(1);
+	if (st25r3916WriteRegister(ST25R3916_REG_MODE, 0x08) != ERR_IO) {
+		printf("FAIL spi error: write not reported\n");
+		return 0;
+	}
+	if ((st25r3916ReadRegister(ST25R3916_REG_MODE, &val) != ERR_NONE) ||
+	    (st25r3916WriteRegister(ST25R3916_REG_MODE, val) != ERR_NONE)) {
+		printf("FAIL spi error: no recovery\n");
+		return 0;
+	}
+	st25r3916GetComStats(&com1);
+	if ((com1.errors - com0.errors) != 2U) {
+		printf("FAIL spi error: %lu errors counted\n",
+		       (unsigned long)(com1.errors - com0.errors));
+		return 0;
+	}
+	if (com1.shadowHits != com0.shadowHits) {
+		printf("FAIL spi error: register read from a stale shadow\n");
+		return 0;
+	}
+	printf("spi error: ok\n");
+	return 1;
+}
+
+int main(void)
+{
+	rfalNfcaListenDevice dev;
+	rfalNfcaSensRes sens_res;
+	nfca_tag_t tag;
+	uint8_t dev_cnt = 0;
+	int ok = 1;
+
+	st25r3916SimReset();
+	nfca_tag_init(&tag, tag_uid, sizeof(tag_uid), 0x00, NULL);
+	st25r3916SimSetPeer(nfca_tag_peer, &tag);
+
+	rfalAnalogConfigInitialize();
+	ok = ok && check(rfalInitialize(), "rfalInitialize");
+	ok = ok && check(rfalNfcaPollerInitialize(), "rfalNfcaPollerInitialize");
+	ok = ok && check(rfalFieldOnAndStartGT(), "rfalFieldOnAndStartGT");
+	ok = ok && check(rfalNfcaPollerTechnologyDetection(RFAL_COMPLIANCE_MODE_NFC, &sens_res),
+			 "rfalNfcaPollerTechnologyDetection");
+	ok = ok && check(rfalNfcaPollerFullCollisionResolution(RFAL_COMPLIANCE_MODE_NFC, 1, &dev, &dev_cnt),
+			 "rfalNfcaPollerFullCollisionResolution");
+
+	if (ok) {
+		if ((dev_cnt != 1) || (dev.nfcId1Len != NFCA_TAG_UID_LEN) ||
+		    (memcmp(dev.nfcId1, tag_uid, NFCA_TAG_UID_LEN) != 0) ||
+		    (dev.selRes.sak != tag.sak) || (tag.state != NFCA_TAG_ACTIVE)) {
+			printf("FAIL tag: %u device(s), UID length %u, SAK 0x%02x\n",
+			       (unsigned int)dev_cnt, (unsigned int)dev.nfcId1Len, (unsigned int)dev.selRes.sak);
+			ok = 0;
+		} else {
+			printf("tag: UID %02X%02X%02X%02X%02X%02X%02X SAK 0x%02x\n",
+			       dev.nfcId1[0], dev.nfcId1[1], dev.nfcId1[2], dev.nfcId1[3],
+			       dev.nfcId1[4], dev.nfcId1[5], dev.nfcId1[6], (unsigned int)dev.selRes.sak);
+		}
+	}
+
+	ok = ok && check_spi_error();
+
+	rfalFieldOff();
+	print_stats();
+
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,374 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Table driven ISO15693 VCD coding and VICC decoding (rfal_iso15693_2.c)
+ * against the original ST implementation (rfal_iso15693_2_ref.c, built
+ * with its functions renamed ref*, see the Makefile).
+ *
+ * Every byte value is coded in 1 of 4 and 1 of 256, with and without CRC,
+ * flags and PicoPass mode, in one call and in minimal output chunks.
+ * Every byte value is decoded from a clean, a CRC protected and a
+ * collided manchester frame. Random frames, corrupted or not, follow.
+ * Return codes, output buffers and every output parameter must match.
+ *
+ * The time taken by both implementations to code and decode a frame is
+ * reported, it is only informative on the host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "platform.h"
+#include "rfal_iso15693_2.h"
+#include "rfal_crc.h"
+
+#define CODE_BUF_LEN	(2 + 65 * 64)
+#define DEC_BUF_LEN	400
+#define DEC_OUT_LEN	300
+#define RANDOM_RUNS	200000
+#define BENCH_LEN	32		/* Frame bytes, CRC excluded */
+#define BENCH_RUNS	20000
+
+ReturnCode refIso15693PhyConfigure(const rfalIso15693PhyConfig_t *config, const struct iso15693StreamConfig **needed_stream_config);
+ReturnCode refIso15693VCDCode(uint8_t *buffer, uint16_t length, bool sendCrc, bool sendFlags, bool picopassMode,
+			      uint16_t *subbit_total_length, uint16_t *offset,
+			      uint8_t *outbuf, uint16_t outBufSize, uint16_t *actOutBufSize);
+ReturnCode refIso15693VICCDecode(const uint8_t *inBuf, uint16_t inBufLen, uint8_t *outBuf, uint16_t outBufLen,
+				 uint16_t *outBufPos, uint16_t *bitsBeforeCol, uint16_t ignoreBits, bool picopassMode);
+
+typedef ReturnCode (*code_fn)(uint8_t *buffer, uint16_t length, bool sendCrc, bool sendFlags, bool picopassMode,
+			      uint16_t *subbit_total_length, uint16_t *offset,
+			      uint8_t *outbuf, uint16_t outBufSize, uint16_t *actOutBufSize);
+
+/* Coding output of a whole frame, all calls included */
+typedef struct {
+	uint8_t frame[64];
+	uint8_t out[CODE_BUF_LEN];
+	uint16_t out_len;
+	uint16_t subbits;
+	uint16_t offset;
+	ReturnCode err[80];
+	unsigned int calls;
+} code_res_t;
+
+typedef ReturnCode (*dec_fn)(const uint8_t *inBuf, uint16_t inBufLen, uint8_t *outBuf, uint16_t outBufLen,
+			     uint16_t *outBufPos, uint16_t *bitsBeforeCol, uint16_t ignoreBits, bool picopassMode);
+
+typedef struct {
+	uint8_t out[DEC_OUT_LEN];
+	uint16_t pos;
+	uint16_t col;
+	ReturnCode err;
+} dec_res_t;
+
+static uint8_t dec_in[DEC_BUF_LEN];
+static int dec_bits;
+
+static void configure(rfalIso15693VcdCoding_t coding)
+{
+	const struct iso15693StreamConfig *stream;
+	rfalIso15693PhyConfig_t config;
+
+	config.coding = coding;
+	config.speedMode = 0;
+	rfalIso15693PhyConfigure(&config, &stream);
+	refIso15693PhyConfigure(&config, &stream);
+}
+
+/* Codes a frame, chunk 0 gives the whole output buffer to a single call */
+static void code(code_fn fn, const uint8_t *frame, uint16_t len, bool crc, bool flags, bool picopass,
+		 uint16_t chunk, code_res_t *res)
+{
+	uint16_t act;
+	uint16_t size;
+	ReturnCode err;
+
+	memset(res, 0, sizeof(*res));
+	memcpy(res->frame, frame, len);
+	memset(res->out, 0xAA, sizeof(res->out));
+
+	do {
+		size = ((chunk == 0) || (chunk > (CODE_BUF_LEN - res->out_len))) ? (CODE_BUF_LEN - res->out_len) : chunk;
+		act = 0;
+		err = fn(res->frame, len, crc, flags, picopass, &res->subbits, &res->offset,
+			 &res->out[res->out_len], size, &act);
+		res->out_len += act;
+		res->err[res->calls++] = err;
+	} while ((err == ERR_AGAIN) && (res->calls < (sizeof(res->err) / sizeof(res->err[0]))));
+}
+
+static int code_cmp(const uint8_t *frame, uint16_t len, bool crc, bool flags, bool picopass, uint16_t chunk)
+{
+	static code_res_t a, b;
+
+	code(rfalIso15693VCDCode, frame, len, crc, flags, picopass, chunk, &a);
+	code(refIso15693VCDCode, frame, len, crc, flags, picopass, chunk, &b);
+	if (memcmp(&a, &b, sizeof(a)) != 0) {
+		printf("FAIL code: %u bytes (0x%02x...), crc %d, flags %d, picopass %d, chunk %u\n",
+		       (unsigned int)len, (len != 0) ? frame[0] : 0, crc, flags, picopass, (unsigned int)chunk);
+		return 0;
+	}
+	return 1;
+}
+
+static int code_all(void)
+{
+	static const rfalIso15693VcdCoding_t codings[] = { ISO15693_VCD_CODING_1_4, ISO15693_VCD_CODING_1_256 };
+	uint8_t frame[64];
+	unsigned int c, v, opt, run;
+	uint16_t chunk, len;
+
+	for (c = 0; c < 2; c++) {
+		configure(codings[c]);
+		/* Smallest output buffers accepted per call, see rfalIso15693VCDCode() */
+		chunk = (codings[c] == ISO15693_VCD_CODING_1_4) ? 5 : 65;
+
+		for (v = 0; v < 256; v++) {
+			for (opt = 0; opt < 8; opt++) {
+				frame[0] = (uint8_t)v;
+				frame[1] = (uint8_t)~v;
+				frame[2] = (uint8_t)(v * 37);
+				if (!code_cmp(frame, 1, opt & 1, opt & 2, opt & 4, 0) ||
+				    !code_cmp(frame, 3, opt & 1, opt & 2, opt & 4, 0) ||
+				    !code_cmp(frame, 3, opt & 1, opt & 2, opt & 4, chunk))
+					return 0;
+			}
+		}
+
+		srand(c + 1);
+		for (run = 0; run < 2000; run++) {
+			len = (uint16_t)(rand() % 64);
+			for (v = 0; v < len; v++)
+				frame[v] = (uint8_t)rand();
+			opt = (unsigned int)rand();
+			if (!code_cmp(frame, len, opt & 1, opt & 2, opt & 4, (opt & 8) ? chunk : 0))
+				return 0;
+		}
+	}
+
+	printf("code: ok\n");
+	return 1;
+}
+
+static void put_bit(int bit)
+{
+	if (bit)
+		dec_in[dec_bits / 8] |= (uint8_t)(1U << (dec_bits % 8));
+	dec_bits++;
+}
+
+/* Manchester coded VICC frame as reported by the stream mode: SOF, data LSB first, EOF */
+static uint16_t dec_frame(const uint8_t *data, uint16_t len)
+{
+	uint16_t i;
+	int b;
+
+	memset(dec_in, 0, sizeof(dec_in));
+	dec_bits = 0;
+
+	put_bit(1); put_bit(1); put_bit(1); put_bit(0); put_bit(1);
+	for (i = 0; i < len; i++) {
+		for (b = 0; b < 8; b++) {
+			put_bit(!((data[i] >> b) & 1));
+			put_bit((data[i] >> b) & 1);
+		}
+	}
+	put_bit(1); put_bit(0); put_bit(1); put_bit(1); put_bit(1); put_bit(0); put_bit(0); put_bit(0);
+
+	return (uint16_t)((dec_bits + 7) / 8);
+}
+
+static int dec_cmp(uint16_t in_len, uint16_t out_len, uint16_t ignore, bool picopass)
+{
+	static dec_res_t a, b;
+
+	memset(&a, 0xAA, sizeof(a));
+	memset(&b, 0xAA, sizeof(b));
+	a.err = rfalIso15693VICCDecode(dec_in, in_len, a.out, out_len, &a.pos, &a.col, ignore, picopass);
+	b.err = refIso15693VICCDecode(dec_in, in_len, b.out, out_len, &b.pos, &b.col, ignore, picopass);
+	if (memcmp(&a, &b, sizeof(a)) != 0) {
+		printf("FAIL decode: %u bytes in, %u bytes out, ignore %u, picopass %d: err %d/%d, pos %u/%u, col %u/%u\n",
+		       (unsigned int)in_len, (unsigned int)out_len, (unsigned int)ignore, picopass,
+		       (int)a.err, (int)b.err, (unsigned int)a.pos, (unsigned int)b.pos,
+		       (unsigned int)a.col, (unsigned int)b.col);
+		return 0;
+	}
+	return 1;
+}
+
+static uint16_t add_crc(uint8_t *data, uint16_t len, bool picopass)
+{
+	uint16_t crc;
+
+	crc = rfalCrcCalculateCcitt(picopass ? 0xE012 : 0xFFFF, data, len);
+	if (!picopass)
+		crc = (uint16_t)~crc;
+	data[len++] = (uint8_t)(crc & 0xFF);
+	data[len++] = (uint8_t)(crc >> 8);
+	return len;
+}
+
+static int decode_all(void)
+{
+	uint8_t data[64];
+	unsigned int v, run, i, k;
+	uint16_t len, in_len, out_len, ignore;
+	int p;
+	bool picopass;
+
+	for (v = 0; v < 256; v++) {
+		for (p = 0; p < 2; p++) {
+			picopass = p;
+
+			/* Single byte, no CRC */
+			data[0] = (uint8_t)v;
+			in_len = dec_frame(data, 1);
+			if (!dec_cmp(in_len, DEC_OUT_LEN, 0, picopass) || !dec_cmp(in_len, 1, 0, picopass))
+				return 0;
+
+			/* Flags, byte value and CRC */
+			data[0] = 0x00;
+			data[1] = (uint8_t)v;
+			data[2] = (uint8_t)(v ^ 0xA5);
+			len = add_crc(data, 3, picopass);
+			in_len = dec_frame(data, len);
+			if (!dec_cmp(in_len, DEC_OUT_LEN, 0, picopass) || !dec_cmp(in_len, DEC_OUT_LEN, 8, picopass))
+				return 0;
+
+			/* Collision (both manchester halves set) in the byte, bit v % 8 */
+			dec_in[(5 + 16 + 2 * (v % 8)) / 8] |= (uint8_t)(1U << ((5 + 16 + 2 * (v % 8)) % 8));
+			if (!dec_cmp(in_len, DEC_OUT_LEN, 0, picopass))
+				return 0;
+		}
+	}
+
+	srand(7);
+	for (run = 0; run < RANDOM_RUNS; run++) {
+		k = (unsigned int)rand() % 3;
+		if (k == 0) {
+			/* Noise with a valid SOF */
+			memset(dec_in, 0, sizeof(dec_in));
+			in_len = (uint16_t)(1 + rand() % (DEC_BUF_LEN - 1));
+			for (i = 0; i < in_len; i++)
+				dec_in[i] = (uint8_t)rand();
+			dec_in[0] = (uint8_t)((dec_in[0] & 0xE0) | 0x17);
+		} else {
+			len = (uint16_t)(rand() % 40);
+			for (i = 0; i < len; i++)
+				data[i] = (uint8_t)rand();
+			if (rand() % 2)
+				len = add_crc(data, len, false);
+			in_len = (uint16_t)(dec_frame(data, len) + rand() % 3);
+			/* Bit errors */
+			if (k == 2) {
+				for (i = (unsigned int)rand() % 4; i > 0; i--) {
+					int pos = 5 + rand() % (dec_bits - 5);
+					dec_in[pos / 8] ^= (uint8_t)(1U << (pos % 8));
+				}
+			}
+		}
+		out_len = (rand() % 2) ? (uint16_t)(1 + rand() % 60) : 256;
+		ignore = (rand() % 3 == 0) ? (uint16_t)(rand() % 200) : 0;
+		picopass = (rand() % 4 == 0);
+		if (!dec_cmp(in_len, out_len, ignore, picopass))
+			return 0;
+	}
+
+	printf("decode: ok\n");
+	return 1;
+}
+
+static double elapsed_ns(const struct timespec *t0, const struct timespec *t1)
+{
+	return ((double)(t1->tv_sec - t0->tv_sec) * 1e9) + (double)(t1->tv_nsec - t0->tv_nsec);
+}
+
+/* Time per frame of coding a whole BENCH_LEN bytes frame with CRC */
+static double bench_code(code_fn fn, const uint8_t *frame)
+{
+	static uint8_t out[CODE_BUF_LEN];
+	uint8_t buf[BENCH_LEN];
+	uint16_t subbits, offset, act;
+	struct timespec t0, t1;
+	int run;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (run = 0; run < BENCH_RUNS; run++) {
+		memcpy(buf, frame, BENCH_LEN);
+		subbits = 0;
+		offset = 0;
+		fn(buf, BENCH_LEN, true, false, false, &subbits, &offset, out, CODE_BUF_LEN, &act);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	return elapsed_ns(&t0, &t1) / BENCH_RUNS;
+}
+
+/* Time per frame of decoding the frame in dec_in */
+static double bench_decode(dec_fn fn, uint16_t in_len)
+{
+	static dec_res_t res;
+	struct timespec t0, t1;
+	int run;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (run = 0; run < BENCH_RUNS; run++)
+		res.err = fn(dec_in, in_len, res.out, DEC_OUT_LEN, &res.pos, &res.col, 0, false);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	return elapsed_ns(&t0, &t1) / BENCH_RUNS;
+}
+
+static void bench(void)
+{
+	uint8_t frame[BENCH_LEN + 2];
+	double ref, lut;
+	uint16_t in_len;
+	unsigned int i;
+
+	for (i = 0; i < BENCH_LEN; i++)
+		frame[i] = (uint8_t)(i * 37);
+
+	configure(ISO15693_VCD_CODING_1_4);
+	ref = bench_code(refIso15693VCDCode, frame);
+	lut = bench_code(rfalIso15693VCDCode, frame);
+	printf("code 1/4, %u bytes: ref %.0f ns, table %.0f ns (x%.1f)\n", BENCH_LEN, ref, lut, ref / lut);
+
+	configure(ISO15693_VCD_CODING_1_256);
+	ref = bench_code(refIso15693VCDCode, frame);
+	lut = bench_code(rfalIso15693VCDCode, frame);
+	printf("code 1/256, %u bytes: ref %.0f ns, table %.0f ns (x%.1f)\n", BENCH_LEN, ref, lut, ref / lut);
+
+	in_len = dec_frame(frame, add_crc(frame, BENCH_LEN, false));
+	ref = bench_decode(refIso15693VICCDecode, in_len);
+	lut = bench_decode(rfalIso15693VICCDecode, in_len);
+	printf("decode, %u bytes: ref %.0f ns, table %.0f ns (x%.1f)\n", BENCH_LEN, ref, lut, ref / lut);
+}
+
+int main(void)
+{
+	int ok;
+
+	ok = code_all();
+	ok = decode_all() && ok;
+	bench();
+
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
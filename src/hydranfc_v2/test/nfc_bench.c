@@ -0,0 +1,360 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Cost of the HydraNFC v2 NFC operations against the simulated chip, as
+ * accounted by the firmware profiler (hydranfc_v2_prof_*()): SPI
+ * transactions, SPI bytes and simulated time per operation.
+ *  - poll cycle and anticollision: ScanTags() of rfal_poller.c on a
+ *    scripted ISO-DEP tag
+ *  - APDU exchange: hydranfc_v2_reader_connect()/_send() of
+ *    hydranfc_v2_reader.c on the same tag
+ *  - CE response: ce.c emulating a MIFARE Ultralight to a scripted
+ *    reader (anticollision by the chip automatic responses, then READ
+ *    commands), driven the way ceRun() of hydranfc_v2_ce.c does
+ * Every operation must complete with the expected answers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+#include "rfal_rf.h"
+#include "rfal_analogConfig.h"
+#include "rfal_isoDep.h"
+#include "st25r3916_com.h"
+
+#include "common.h"
+#include "ce.h"
+#include "hydranfc_v2.h"
+#include "hydranfc_v2_ce.h"
+#include "hydranfc_v2_reader.h"
+#include "rfal_poller.h"
+
+#include "nfca_tag.h"
+
+#define SCAN_RUNS	3
+#define APDU_RUNS	3
+#define CE_READS	4	/* READ commands of the reader, 4 pages each */
+#define CE_TIMEOUT_NS	1000000000ULL
+
+#define UL_READ		0x30
+#define UL_NAK		0x00
+
+/* ISO-DEP tag, single size UID */
+static const uint8_t tag_uid[] = { 0x5A, 0x11, 0x22, 0x33 };
+static const uint8_t tag_ats[] = { 0x05, 0x78, 0x00, 0x80, 0x02 };	/* FSCI 8, 106kb/s only, FWI 8, CID */
+static const uint8_t tag_rapdu[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x90, 0x00 };
+static char apdu[] = "00A4040007D276000085010100";	/* SELECT NDEF application */
+static unsigned int tag_apdus;
+
+/* Card emulation, stands for the globals of hydranfc_v2_ce.c */
+sUserTagProperties user_tag_properties;
+uint8_t ul_cwrite_page_set;
+
+static uint8_t ul_image[64];
+
+typedef struct {
+	uint8_t level;		/* Cascade level being selected */
+	uint8_t page;		/* Page of the last READ */
+	unsigned int reads;	/* READ answers checked */
+	unsigned int errors;
+} ce_reader_t;
+
+static uint16_t add_crc(uint8_t *buf, uint16_t len)
+{
+	uint16_t crc = st25r3916SimCrcA(buf, len);
+
+	buf[len++] = (uint8_t)(crc & 0xFF);
+	buf[len++] = (uint8_t)(crc >> 8);
+	return len;
+}
+
+/* ISO14443-4 layer of the scripted tag: ATS, PPS, DESELECT, APDUs */
+static uint16_t iso_dep_app(const uint8_t *rx, uint16_t rx_len, uint8_t *tx)
+{
+	uint16_t hdr;
+
+	if ((rx_len == 2) && (rx[0] == 0xE0)) {
+		memcpy(tx, tag_ats, sizeof(tag_ats));
+		return sizeof(tag_ats);
+	}
+	if ((rx[0] & 0xF0) == 0xD0) {
+		tx[0] = rx[0];
+		return 1;
+	}
+
+	/* PCB, CID if any */
+	hdr = ((rx[0] & 0x08) != 0) ? 2 : 1;
+	if (rx_len < hdr)
+		return 0;
+	if ((rx[0] & 0xF7) == 0xC2) {
+		memcpy(tx, rx, hdr);
+		return hdr;
+	}
+	if ((rx[0] & 0xE6) == 0x02) {
+		memcpy(tx, rx, hdr);
+		memcpy(&tx[hdr], tag_rapdu, sizeof(tag_rapdu));
+		tag_apdus++;
+		return hdr + sizeof(tag_rapdu);
+	}
+	return 0;
+}
+
+/* Console of the firmware code, kept in memory for the checks */
+static char *out_buf;
+static size_t out_len;
+
+static void out_open(t_hydra_console *con)
+{
+	con->out = open_memstream(&out_buf, &out_len);
+}
+
+static const char *out_close(t_hydra_console *con)
+{
+	fclose(con->out);
+	con->out = NULL;
+	return out_buf;
+}
+
+static int expect(const char *out, const char *what, const char *text)
+{
+	if (strstr(out, text) == NULL) {
+		printf("FAIL %s: \"%s\" not found in:\n%s\n", what, text, out);
+		return 0;
+	}
+	return 1;
+}
+
+static int bench_reader(void)
+{
+	static t_hydra_console con;
+	nfca_tag_t tag;
+	char rapdu[3 * sizeof(tag_rapdu) + 1];
+	unsigned int i;
+	int ok = 1;
+
+	nfca_tag_init(&tag, tag_uid, sizeof(tag_uid), 0x20, iso_dep_app);
+	st25r3916SimSetPeer(nfca_tag_peer, &tag);
+
+	out_open(&con);
+	for (i = 0; i < SCAN_RUNS; i++)
+		ScanTags(&con, NFC_A);
+	ok = expect(out_close(&con), "poll", " ATS=0x0578008002 UID:5A112233");
+	free(out_buf);
+
+	for (i = 0; i < sizeof(tag_rapdu); i++)
+		sprintf(&rapdu[3 * i], "%02X ", tag_rapdu[i]);
+
+	out_open(&con);
+	hydranfc_v2_reader_set_opt(&con, T_CARD_CONNECT_AUTO_OPT_VERBOSITY, 0);
+	hydranfc_v2_reader_connect(&con);
+	for (i = 0; i < APDU_RUNS; i++)
+		hydranfc_v2_reader_send(&con, (uint8_t *)apdu);
+	out_close(&con);
+	ok = ok && expect(out_buf, "connect", "ISO 14443-A card detected.") && expect(out_buf, "APDU", rapdu);
+	free(out_buf);
+
+	if (ok && (tag_apdus != APDU_RUNS)) {
+		printf("FAIL APDU: %u received by the tag, %u sent\n", tag_apdus, APDU_RUNS);
+		ok = 0;
+	}
+	return ok;
+}
+
+/* Reader of the CE bench: anticollision, then READ of CE_READS page groups */
+static uint16_t ce_reader_read(ce_reader_t *rd, uint8_t *tx)
+{
+	tx[0] = UL_READ;
+	tx[1] = rd->page;
+	return 8 * add_crc(tx, 2);
+}
+
+static uint16_t ce_reader_peer(void *ctx, const uint8_t *rx, uint16_t rx_bits, uint8_t *tx)
+{
+	ce_reader_t *rd = ctx;
+	uint8_t data[18];
+
+	switch (rx_bits) {
+	case 16:	/* ATQA */
+		tx[0] = 0x93;
+		tx[1] = 0x20;
+		return 16;
+
+	case 40:	/* CLn and BCC */
+		tx[0] = (uint8_t)(0x93 + (2 * rd->level));
+		tx[1] = 0x70;
+		memcpy(&tx[2], rx, 5);
+		return 8 * add_crc(tx, 7);
+
+	case 24:	/* SAK */
+		if ((rx[0] & 0x04) != 0) {
+			rd->level++;
+			tx[0] = (uint8_t)(0x93 + (2 * rd->level));
+			tx[1] = 0x20;
+			return 16;
+		}
+		return ce_reader_read(rd, tx);
+
+	case 8 * sizeof(data):	/* READ answer, 4 pages */
+		memcpy(data, &ul_image[rd->page * 4], 16);
+		add_crc(data, 16);
+		if (memcmp(rx, data, sizeof(data)) != 0) {
+			rd->errors++;
+			return 0;
+		}
+		if (++rd->reads == CE_READS)
+			return 0;
+		rd->page += 4;
+		return ce_reader_read(rd, tx);
+
+	default:
+		rd->errors++;
+		return 0;
+	}
+}
+
+/* Stands for processCmdMifUL() of hydranfc_v2_ce.c, READ only, answer length in bits */
+static uint16_t ul_process(uint8_t *cmd, uint16_t cmd_len, uint8_t *rsp)
+{
+	uint8_t page;
+
+	if ((cmd_len == 2) && (cmd[0] == UL_READ) && (cmd[1] < (sizeof(ul_image) / 4))) {
+		page = cmd[1];
+		memcpy(rsp, &ul_image[page * 4], 16);
+		return 8 * 16;
+	}
+	rsp[0] = UL_NAK;
+	return 4;
+}
+
+/* One run of ceRun() of hydranfc_v2_ce.c */
+static void ce_run(void)
+{
+	static uint8_t frame[256 + 3];
+	hydranfc_v2_prof_mark_t prof_mark;
+	uint16_t size;
+
+	rfalWorker();
+	ceHandler();
+
+	size = sizeof(frame);
+	if (ceGetRx(CARDEMULATION_CMD_GET_RX_A, frame, &size) == ERR_NONE) {
+		hydranfc_v2_prof_start(&prof_mark);
+		size = ul_process(frame, size, frame);
+		ceSetTx(CARDEMULATION_CMD_SET_TX_A, frame, size, false);
+		hydranfc_v2_prof_stop(HYDRANFC_V2_PROF_CE_RESPONSE, &prof_mark);
+	}
+}
+
+static int bench_ce(void)
+{
+	/* hydranfc_ce_common() start command, layer 3 MIFARE Ultralight */
+	uint8_t startCmd[] = {
+		CARDEMULATION_MODE_NDEF,
+		0x04, 0x0E,
+		0x07,
+		0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x00, 0x00, 0x00,
+		0x44, 0x00,
+		0x00,
+		0x04, 0x00, 0x04, 0x00,
+		0x04, 0x00
+	};
+	const uint8_t reqa = 0x26;
+	ce_reader_t rd;
+	ReturnCode err;
+	uint64_t start;
+	unsigned int i;
+
+	for (i = 0; i < sizeof(ul_image); i++)
+		ul_image[i] = (uint8_t)(0xA0 + i);
+	memset(&user_tag_properties, 0, sizeof(user_tag_properties));
+	memset(&rd, 0, sizeof(rd));
+	st25r3916SimSetPeer(ce_reader_peer, &rd);
+
+	rfalFieldOff();
+	ceInit();
+	rfalIsoDepInitialize();
+	err = ceStart(startCmd, sizeof(startCmd));
+	if (err != ERR_NONE) {
+		printf("FAIL ceStart: error %d\n", (int)err);
+		return 0;
+	}
+
+	/* Reader field on, REQA once the listen mode left POWER_OFF */
+	start = st25r3916SimGetTimeNs();
+	st25r3916SimSetExtField(true);
+	while ((rfalListenGetState(NULL, NULL) == RFAL_LM_STATE_POWER_OFF) &&
+	       ((st25r3916SimGetTimeNs() - start) < CE_TIMEOUT_NS))
+		ce_run();
+	st25r3916SimReaderSend(&reqa, 7);
+
+	while ((rd.reads < CE_READS) && (rd.errors == 0) && ((st25r3916SimGetTimeNs() - start) < CE_TIMEOUT_NS))
+		ce_run();
+
+	st25r3916SimSetExtField(false);
+	ceStop();
+	st25r3916SimSetPeer(NULL, NULL);
+
+	if ((rd.reads != CE_READS) || (rd.errors != 0)) {
+		printf("FAIL CE: %u READ answers ok, %u errors, listen state %d\n",
+		       rd.reads, rd.errors, (int)rfalListenGetState(NULL, NULL));
+		return 0;
+	}
+	return 1;
+}
+
+static int check_prof(const char *name, hydranfc_v2_prof_op_t op, uint32_t count)
+{
+	const hydranfc_v2_prof_t *p = hydranfc_v2_prof_get(op);
+	uint32_t n = (p->count != 0) ? p->count : 1;
+
+	printf("%-14s %2lu ops, per op: %4lu SPI transactions, %5lu SPI bytes, %6lu us (max %lu us)\n",
+	       name, (unsigned long)p->count, (unsigned long)(p->transactions / n),
+	       (unsigned long)(p->bytes / n), (unsigned long)(p->us / n), (unsigned long)p->us_max);
+	if (p->count != count) {
+		printf("FAIL %s: %lu ops profiled, %lu expected\n", name, (unsigned long)p->count, (unsigned long)count);
+		return 0;
+	}
+	return 1;
+}
+
+int main(void)
+{
+	int ok;
+
+	st25r3916SimReset();
+	rfalAnalogConfigInitialize();
+	if (rfalInitialize() != ERR_NONE) {
+		printf("FAIL rfalInitialize\n");
+		return 1;
+	}
+	hydranfc_v2_prof_reset();
+
+	ok = bench_reader();
+	ok = bench_ce() && ok;
+
+	ok = check_prof("poll cycle", HYDRANFC_V2_PROF_POLL, SCAN_RUNS) && ok;
+	ok = check_prof("anticollision", HYDRANFC_V2_PROF_ANTICOL, SCAN_RUNS) && ok;
+	ok = check_prof("APDU exchange", HYDRANFC_V2_PROF_APDU, APDU_RUNS) && ok;
+	ok = check_prof("CE response", HYDRANFC_V2_PROF_CE_RESPONSE, CE_READS) && ok;
+
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "st25r3916_sim.h"
+#include "nfca_tag.h"
+
+#define NFCA_REQA	0x26
+#define NFCA_WUPA	0x52
+#define NFCA_HLTA	0x50
+#define NFCA_SEL_CL1	0x93
+#define NFCA_SEL_CL2	0x95
+#define NFCA_CT		0x88	/* Cascade tag */
+#define NFCA_NVB_SDD	0x20	/* Anticollision, SEL and NVB only */
+#define NFCA_NVB_SEL	0x70	/* SELECT, full UID CLn */
+#define NFCA_SAK_MORE	0x04	/* UID not complete */
+
+static uint16_t nfca_tag_add_crc(uint8_t *tx, uint16_t len)
+{
+	uint16_t crc;
+
+	crc = st25r3916SimCrcA(tx, len);
+	tx[len++] = (uint8_t)(crc & 0xFF);
+	tx[len++] = (uint8_t)(crc >> 8);
+	return len;
+}
+
+static int nfca_tag_crc_ok(const uint8_t *rx, uint16_t len)
+{
+	uint16_t crc;
+
+	if (len < 3)
+		return 0;
+	crc = st25r3916SimCrcA(rx, len - 2);
+	return (rx[len - 2] == (uint8_t)(crc & 0xFF)) && (rx[len - 1] == (uint8_t)(crc >> 8));
+}
+
+/* NFCID1 CLn and BCC of the given cascade level */
+static void nfca_tag_cln(const nfca_tag_t *tag, uint8_t level, uint8_t *cln)
+{
+	if (tag->uid_len == 4) {
+		memcpy(&cln[0], &tag->uid[0], 4);
+	} else if (level == 0) {
+		cln[0] = NFCA_CT;
+		memcpy(&cln[1], &tag->uid[0], 3);
+	} else {
+		memcpy(&cln[0], &tag->uid[3], 4);
+	}
+	cln[4] = cln[0] ^ cln[1] ^ cln[2] ^ cln[3];
+}
+
+/* Unexpected frame: back to IDLE, or HALT if it was halted */
+static uint16_t nfca_tag_reset(nfca_tag_t *tag)
+{
+	tag->state = (tag->state == NFCA_TAG_HALT) ? NFCA_TAG_HALT : NFCA_TAG_IDLE;
+	tag->level = 0;
+	return 0;
+}
+
+void nfca_tag_init(nfca_tag_t *tag, const uint8_t *uid, uint8_t uid_len, uint8_t sak, nfca_tag_app_fn app)
+{
+	memset(tag, 0, sizeof(*tag));
+	tag->uid_len = (uid_len == 4) ? 4 : NFCA_TAG_UID_LEN;
+	memcpy(tag->uid, uid, tag->uid_len);
+	/* Single or double size UID, bit frame anticollision */
+	tag->atqa[0] = (tag->uid_len == 4) ? 0x04 : 0x44;
+	tag->atqa[1] = 0x00;
+	tag->sak = sak;
+	tag->app = app;
+	tag->state = NFCA_TAG_IDLE;
+}
+
+uint16_t nfca_tag_peer(void *ctx, const uint8_t *rx, uint16_t rx_bits, uint8_t *tx)
+{
+	nfca_tag_t *tag = ctx;
+	uint16_t len;
+	uint8_t cln[5];
+	uint8_t sel;
+
+	tag->frames++;
+
+	/* Short frames */
+	if (rx_bits == 7) {
+		if ((rx[0] == NFCA_WUPA) || ((rx[0] == NFCA_REQA) && (tag->state != NFCA_TAG_HALT))) {
+			tag->state = NFCA_TAG_READY;
+			tag->level = 0;
+			memcpy(tx, tag->atqa, 2);
+			return 16;
+		}
+		return nfca_tag_reset(tag);
+	}
+
+	if ((rx_bits % 8) != 0)
+		return nfca_tag_reset(tag);
+	len = rx_bits / 8;
+
+	switch (tag->state) {
+	case NFCA_TAG_READY:
+		sel = (tag->level == 0) ? NFCA_SEL_CL1 : NFCA_SEL_CL2;
+		if ((len < 2) || (rx[0] != sel))
+			return nfca_tag_reset(tag);
+		nfca_tag_cln(tag, tag->level, cln);
+
+		if ((len == 2) && (rx[1] == NFCA_NVB_SDD)) {
+			/* SDD_RES, no CRC */
+			memcpy(tx, cln, sizeof(cln));
+			return 8 * sizeof(cln);
+		}
+
+		if ((len == 9) && (rx[1] == NFCA_NVB_SEL) && nfca_tag_crc_ok(rx, len) &&
+		    (memcmp(&rx[2], cln, sizeof(cln)) == 0)) {
+			if ((tag->uid_len == NFCA_TAG_UID_LEN) && (tag->level == 0)) {
+				tag->level = 1;
+				tx[0] = NFCA_SAK_MORE;
+			} else {
+				tag->state = NFCA_TAG_ACTIVE;
+				tx[0] = tag->sak;
+			}
+			return 8 * nfca_tag_add_crc(tx, 1);
+		}
+		return nfca_tag_reset(tag);
+
+	case NFCA_TAG_ACTIVE:
+		if (!nfca_tag_crc_ok(rx, len))
+			return 0;
+		if ((len == 4) && (rx[0] == NFCA_HLTA) && (rx[1] == 0x00)) {
+			tag->state = NFCA_TAG_HALT;
+			return 0;
+		}
+		if (tag->app == NULL)
+			return 0;
+		len = tag->app(rx, len - 2, tx);
+		return (len == 0) ? 0 : (8 * nfca_tag_add_crc(tx, len));
+
+	default:
+		return nfca_tag_reset(tag);
+	}
+}
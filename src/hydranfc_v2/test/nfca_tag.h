@@ -0,0 +1,61 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NFCA_TAG_H
+#define NFCA_TAG_H
+
+/*
+ * Scripted ISO14443-3A tag with a 4 or 7 bytes UID (single or double size,
+ * one or two cascade levels) answering REQA/WUPA, anticollision, SELECT
+ * and HLTA.
+ * Once selected, frames with a valid CRC are handed to an optional
+ * application callback.
+ */
+
+#include <stdint.h>
+
+#define NFCA_TAG_UID_LEN	7	/* Longest UID */
+
+typedef enum {
+	NFCA_TAG_IDLE,
+	NFCA_TAG_READY,
+	NFCA_TAG_ACTIVE,
+	NFCA_TAG_HALT
+} nfca_tag_state_t;
+
+/* Application layer of a selected tag, returns the answer length in bytes, CRC excluded */
+typedef uint16_t (*nfca_tag_app_fn)(const uint8_t *rx, uint16_t rx_len, uint8_t *tx);
+
+typedef struct {
+	uint8_t uid[NFCA_TAG_UID_LEN];
+	uint8_t uid_len;
+	uint8_t atqa[2];
+	uint8_t sak;		/* SAK of the last cascade level */
+	nfca_tag_app_fn app;
+
+	nfca_tag_state_t state;
+	uint8_t level;		/* Cascade level being resolved */
+	uint32_t frames;	/* Frames received */
+} nfca_tag_t;
+
+void nfca_tag_init(nfca_tag_t *tag, const uint8_t *uid, uint8_t uid_len, uint8_t sak, nfca_tag_app_fn app);
+
+/* st25r3916SimPeerFn */
+uint16_t nfca_tag_peer(void *ctx, const uint8_t *rx, uint16_t rx_bits, uint8_t *tx);
+
+#endif /* NFCA_TAG_H */
@@ -0,0 +1,169 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+/* Host platform definitions for ST25RFAL002 V2.4.0, see hal/inc/platform.h for the target */
+
+/*
+******************************************************************************
+* INCLUDES
+******************************************************************************
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "st_errno.h"
+
+#include "timer.h"
+#include "st25r3916_sim.h"
+
+/*
+******************************************************************************
+* GLOBAL DEFINES
+******************************************************************************
+*/
+#define ST25R3916 /* Required by RFAL src/st25r3916/st25r3916.c */
+
+#define HAL_OK                             0 /* Status returned by the simulated SPI */
+
+#define ST25R_SS_PIN                       0U    /*!< GPIO pin used for ST25R SPI SS, not used on host */
+#define ST25R_SS_PORT                      NULL  /*!< GPIO port used for ST25R SPI SS port, not used on host */
+#define ST25R_INT_PIN                      0U    /*!< GPIO pin used for ST25R External Interrupt, not used on host */
+#define ST25R_INT_PORT                     NULL  /*!< GPIO port used for ST25R External Interrupt, not used on host */
+
+/*
+******************************************************************************
+* GLOBAL MACROS
+******************************************************************************
+*/
+#define platformProtectST25RComm()         st25r3916SimProtectComm()                        /*!< Protect unique access to ST25R391x communication channel */
+#define platformUnprotectST25RComm()       st25r3916SimUnprotectComm()                      /*!< Unprotect unique access to ST25R391x communication channel, runs a pending IRQ */
+
+#define platformProtectWorker()            st25r3916SimPoll()                               /*!< Each RFAL worker run lets the simulated time go on */
+#define platformUnprotectWorker()                                                           /*!< Unprotect RFAL Worker/Task/Process */
+
+#define platformGpioIsHigh( port, pin )    st25r3916SimIntIsHigh()                          /*!< Only the ST25R3916 INT line is read */
+#define platformGpioIsLow( port, pin )     (!platformGpioIsHigh(port, pin))                 /*!< Checks if the given GPIO is Low */
+
+#define platformTimerCreate( t )           timerCalculateTimer(t)                           /*!< Create a timer with the given time (ms) */
+#define platformTimerIsExpired( timer )    timerIsExpired(timer)                            /*!< Checks if the given timer is expired */
+#define platformDelay( t )                 st25r3916SimDelayMs( t )                         /*!< Performs a delay for the given time (ms) */
+#define platformTimerCreateUs( t )         timerCalculateTimerUs(t)                         /*!< Create a timer with the given time (us) */
+#define platformTimerCreate1fc( t )        timerCalculateTimerUs(rfalConv1fcToUs(t))        /*!< Create a timer with the given time (1/fc) */
+#define platformDelayUs( t )               timerDelayUs( t )                                /*!< Performs a delay for the given time (us) */
+
+#define platformGetSysTick()               (timerGetUs() / 1000U)                           /*!< Get System Tick (1 tick = 1 ms) */
+#define platformGetSysTickUs()             timerGetUs()                                     /*!< Get the timer time base (1 tick = 1 us) */
+
+#define platformAssert( exp )                                                               /*!< Asserts whether the given expression is true */
+#define platformErrorHandle()                                                               /*!< Global error handle\trap */
+
+#define platformSpiSelect()                st25r3916SimSelect()                             /*!< SPI SS\CS: Chip|Slave Select */
+#define platformSpiDeselect()              st25r3916SimDeselect()                           /*!< SPI SS\CS: Chip|Slave Deselect */
+#define platformSpiTxRx(txBuf, rxBuf, len) st25r3916SimSpiTxRx(txBuf, rxBuf, len)           /*!< SPI transceive */
+#define platformSpiTxRxStart(txBuf, rxBuf, len, cb) st25r3916SimSpiTxRxStart(txBuf, rxBuf, len, cb, NULL) /*!< SPI transceive started in background */
+#define platformSpiTxRxWait()              st25r3916SimSpiWait()                            /*!< Wait for the end of a background SPI transceive */
+
+#define platformLog(...)
+#define LOGGER_ON   1
+#define LOGGER_OFF  0
+#define USE_LOGGER LOGGER_OFF
+
+/*
+******************************************************************************
+* GLOBAL VARIABLES
+******************************************************************************
+*/
+extern uint8_t globalCommProtectCnt; /* Global Protection Counter provided per platform - instantiated in st25r3916_sim.c */
+
+/*
+******************************************************************************
+* RFAL FEATURES CONFIGURATION
+******************************************************************************
+*/
+/* Same configuration as the target, see hal/inc/platform.h */
+#define RFAL_FEATURE_DYNAMIC_ANALOG_CONFIG  true /*!< Enable/Disable Analog Configs to be dynamically updated (RAM) */
+#define RFAL_FEATURE_LOWPOWER_MODE          false /*!< Enable/Disable RFAL support for the Low Power mode */
+
+#define RFAL_FEATURE_NFCA                   true /*!< Enable/Disable RFAL support for NFC-A (ISO14443A) */
+#define RFAL_FEATURE_NFCB                   true /*!< Enable/Disable RFAL support for NFC-B (ISO14443B) */
+#define RFAL_FEATURE_NFCF                   true /*!< Enable/Disable RFAL support for NFC-F (FeliCa) */
+#define RFAL_FEATURE_NFCV                   true /*!< Enable/Disable RFAL support for NFC-V (ISO15693) */
+#define RFAL_FEATURE_T1T                    true /*!< Enable/Disable RFAL support for T1T (Topaz) */
+#define RFAL_FEATURE_T2T                    true /*!< Enable/Disable RFAL support for T2T (MIFARE Ultralight) */
+#define RFAL_FEATURE_T4T                    true /*!< Enable/Disable RFAL support for T4T */
+#define RFAL_FEATURE_ST25TB                 true /*!< Enable/Disable RFAL support for ST25TB */
+#define RFAL_FEATURE_ST25xV                 true /*!< Enable/Disable RFAL support for ST25TV/ST25DV */
+#define RFAL_FEATURE_ISO_DEP                true /*!< Enable/Disable RFAL support for ISO-DEP (ISO14443-4) */
+#define RFAL_FEATURE_ISO_DEP_POLL           true /*!< Enable/Disable RFAL support for Poller mode (PCD) ISO-DEP (ISO14443-4) */
+#define RFAL_FEATURE_ISO_DEP_LISTEN         true /*!< Enable/Disable RFAL support for Listen mode (PICC) ISO-DEP (ISO14443-4) */
+#define RFAL_FEATURE_NFC_DEP                true /*!< Enable/Disable RFAL support for NFC-DEP (NFCIP1/P2P) */
+#define RFAL_FEATURE_LISTEN_MODE            true /*!< Enable/Disable RFAL support for Listen Mode */
+#define RFAL_FEATURE_WAKEUP_MODE            true /*!< Enable/Disable RFAL support for the Wake-Up mode */
+#define RFAL_FEATURE_DPO                    true /*!< Enable/Disable RFAL Dynamic Power Output support */
+
+#define RFAL_FEATURE_ISO_DEP_IBLOCK_MAX_LEN 256U /*!< ISO-DEP I-Block max length. Please use values as defined by rfalIsoDepFSx */
+#define RFAL_FEATURE_NFC_DEP_BLOCK_MAX_LEN  254U /*!< NFC-DEP Block/Payload length. Allowed values: 64, 128, 192, 254 */
+#define RFAL_FEATURE_NFC_RF_BUF_LEN         256U /*!< RF buffer length used by RFAL NFC layer */
+
+#define RFAL_FEATURE_ISO_DEP_APDU_MAX_LEN   512U /*!< ISO-DEP APDU max length. */
+#define RFAL_FEATURE_NFC_DEP_PDU_MAX_LEN    512U /*!< NFC-DEP PDU max length. */
+
+/* Use HydraNFC Shield v2 RFAL Analog Config Custom */
+#define RFAL_ANALOG_CONFIG_CUSTOM           true
+
+/* SELFTEST Helpfull to diagnose porting issues.  */
+#define ST25R_SELFTEST
+#define ST25R_SELFTEST_TIMER
+
+/*
+ ******************************************************************************
+ * RFAL OPTIONAL MACROS            (Do not change)
+ ******************************************************************************
+ */
+#ifndef platformProtectST25RIrqStatus
+    #define platformProtectST25RIrqStatus()   /*!< The IRQ only runs in between RFAL calls on host */
+#endif /* platformProtectST25RIrqStatus */
+
+#ifndef platformUnprotectST25RIrqStatus
+    #define platformUnprotectST25RIrqStatus() /*!< The IRQ only runs in between RFAL calls on host */
+#endif /* platformUnprotectST25RIrqStatus */
+
+#ifndef platformIrqST25RPinInitialize
+    #define platformIrqST25RPinInitialize()   /*!< Initializes ST25R IRQ pin */
+#endif /* platformIrqST25RPinInitialize */
+
+#ifndef platformIrqST25RSetCallback
+    #define platformIrqST25RSetCallback( cb ) /*!< Sets ST25R ISR callback */
+#endif /* platformIrqST25RSetCallback */
+
+#ifndef platformLedsInitialize
+    #define platformLedsInitialize()          /*!< Initializes the pins used as LEDs to outputs */
+#endif /* platformLedsInitialize */
+
+#ifndef platformTimerDestroy
+    #define platformTimerDestroy( timer )     /*!< Stops and released the given timer */
+#endif /* platformTimerDestroy */
+
+#endif /* PLATFORM_H */
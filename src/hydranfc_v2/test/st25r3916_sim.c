@@ -0,0 +1,1153 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "platform.h"
+#include "st25r3916.h"
+#include "st25r3916_com.h"
+#include "st25r3916_irq.h"
+#include "rfal_crc.h"
+
+#define SIM_FC_HZ          13560000ULL
+#define SIM_FC_TO_NS(n)    ((((uint64_t)(n) * 1000000000ULL) + SIM_FC_HZ - 1U) / SIM_FC_HZ)
+
+#define SIM_START_NS       1000000000ULL        /* Virtual clock at reset, keeps timers away from 0 */
+#define SIM_POLL_NS        1000U                /* Time spent by a busy loop iteration              */
+#define SIM_SPI_BYTE_NS    1000U                /* SPI byte at about 8MHz, gaps included            */
+#define SIM_BIT_NS         SIM_FC_TO_NS(128U)   /* 106kb/s bit                                      */
+#define SIM_BYTE_NS        (9U * SIM_BIT_NS)    /* 8 data bits and the parity bit                   */
+#define SIM_FDT_NS         SIM_FC_TO_NS(1172U)  /* NFC-A frame delay time                           */
+#define SIM_OSC_NS         200000U              /* Oscillator start up                              */
+#define SIM_WUT_NS         10000000U            /* Wake-up timer (wur, wut 0)                       */
+#define SIM_APON_NS        100000U              /* Initial RF collision avoidance                   */
+#define SIM_CAT_NS         75000U               /* Field on guard time (FIELD_ON_GT 0)              */
+#define SIM_DCT_NS         25000U               /* Measure commands                                 */
+#define SIM_ADJUST_NS      1000000U             /* Adjust regulators command                        */
+
+#define SIM_VDD_AD         141U                 /* 3.3V in 23.4mV steps                             */
+#define SIM_REG_RESULT     0xA0U                /* Regulated voltage in REGULATOR_RESULT            */
+#define SIM_IC_IDENTITY    (ST25R3916_REG_IC_IDENTITY_ic_type_st25r3916 | 2U)
+
+#define SIM_REG_NB         ST25R3916_SIM_REG_NB
+#define SIM_IRQ_REGS_NB    4U
+
+typedef enum {
+	SIM_EV_OSC,
+	SIM_EV_WUT,
+	SIM_EV_GPT,
+	SIM_EV_NRT,
+	SIM_EV_APON,
+	SIM_EV_CAT,
+	SIM_EV_DCT,
+	SIM_EV_TX,
+	SIM_EV_RXS,
+	SIM_EV_RX,
+	SIM_EV_PTA,
+	SIM_EV_SPI,
+	SIM_EV_NB
+} sim_ev_t;
+
+typedef enum {
+	SIM_SPI_IDLE,
+	SIM_SPI_WRITE,
+	SIM_SPI_READ,
+	SIM_SPI_FIFO_LOAD,
+	SIM_SPI_FIFO_READ,
+	SIM_SPI_PTM_LOAD,
+	SIM_SPI_PTM_READ,
+	SIM_SPI_CMD
+} sim_spi_mode_t;
+
+typedef enum {
+	SIM_SPACE_A    = ST25R3916_SIM_SPACE_A,
+	SIM_SPACE_B    = ST25R3916_SIM_SPACE_B,
+	SIM_SPACE_TEST = ST25R3916_SIM_SPACE_TEST
+} sim_space_t;
+
+uint8_t globalCommProtectCnt;
+
+static struct {
+	uint64_t now;
+	uint64_t ev[SIM_EV_NB];          /* Event time, 0 when not scheduled       */
+
+	uint8_t  regA[SIM_REG_NB];
+	uint8_t  regB[SIM_REG_NB];
+	uint8_t  regT[SIM_REG_NB];
+	uint8_t  irq[SIM_IRQ_REGS_NB];   /* Latched, unmasked interrupts           */
+	uint8_t  adResult;
+	bool     oscOk;
+	bool     rxAct;
+
+	uint8_t  fifo[ST25R3916_SIM_FIFO_DEPTH];
+	uint16_t fifoHead;
+	uint16_t fifoCnt;
+	uint8_t  fifoLb;                 /* Bits in the last, incomplete, byte     */
+	bool     fifoUnf;
+	bool     fifoOvr;
+
+	bool           cs;
+	sim_spi_mode_t mode;
+	sim_space_t    space;
+	uint8_t        addr;
+
+	const uint8_t *bgTx;             /* Background SPI transfer                */
+	uint8_t       *bgRx;
+	uint16_t       bgLen;
+	void         (*bgCb)(void *param);
+	void          *bgParam;
+	uint32_t       spiFail;          /* Next SPI transfers to fail             */
+
+	uint8_t  txFrame[ST25R3916_SIM_FRAME_MAX];
+	uint16_t txBits;                 /* Frame length, CRC excluded             */
+	uint16_t txFifoBytes;            /* Bytes to take from the FIFO            */
+	uint16_t txPos;
+	bool     txCrc;
+	bool     txLast;                 /* Next SIM_EV_TX ends the frame          */
+
+	uint8_t  rxFrame[ST25R3916_SIM_FRAME_MAX];
+	uint16_t rxBits;
+	uint16_t rxPos;
+
+	bool     extField;               /* Field of an external reader            */
+	bool     nfct;                   /* Bit rate detected since field on       */
+	uint8_t  ptaState;               /* PASSIVE_TARGET_STATUS                  */
+	uint8_t  ptaLevel;               /* Cascade level being resolved           */
+	uint8_t  ptm[ST25R3916_PTM_LEN]; /* Passive target memory                  */
+	uint16_t ptmPos;
+
+	st25r3916SimPeerFn peer;
+	void    *peerCtx;
+	st25r3916SimWriteFn writeHook;
+	void    *writeCtx;
+
+	bool     inIsr;
+	st25r3916SimStats stats;
+} sim;
+
+static uint32_t timerStopwatchTick;
+
+/*
+******************************************************************************
+* FIFO and interrupts
+******************************************************************************
+*/
+static void simIrq(uint32_t irqs)
+{
+	uint8_t i;
+
+	/* Masked interrupts are not latched */
+	for(i = 0; i < SIM_IRQ_REGS_NB; i++) {
+		sim.irq[i] |= (uint8_t)((irqs >> (8U * i)) & ~sim.regA[ST25R3916_REG_IRQ_MASK_MAIN + i]);
+	}
+}
+
+static void simFifoClear(void)
+{
+	sim.fifoHead = 0;
+	sim.fifoCnt  = 0;
+	sim.fifoLb   = 0;
+	sim.fifoUnf  = false;
+	sim.fifoOvr  = false;
+}
+
+static void simFifoPush(uint8_t val)
+{
+	if(sim.fifoCnt >= ST25R3916_SIM_FIFO_DEPTH) {
+		sim.fifoOvr = true;
+		sim.stats.fifoOverflows++;
+		return;
+	}
+	sim.fifo[(sim.fifoHead + sim.fifoCnt) % ST25R3916_SIM_FIFO_DEPTH] = val;
+	sim.fifoCnt++;
+	if(sim.fifoCnt > sim.stats.fifoMax) {
+		sim.stats.fifoMax = sim.fifoCnt;
+	}
+}
+
+static uint8_t simFifoPop(void)
+{
+	uint8_t val;
+
+	if(sim.fifoCnt == 0) {
+		sim.fifoUnf = true;
+		return 0;
+	}
+	val = sim.fifo[sim.fifoHead];
+	sim.fifoHead = (sim.fifoHead + 1U) % ST25R3916_SIM_FIFO_DEPTH;
+	sim.fifoCnt--;
+	return val;
+}
+
+/*
+******************************************************************************
+* Timers
+******************************************************************************
+*/
+static void simStartGpt(void)
+{
+	uint16_t gpt;
+
+	gpt = (uint16_t)((sim.regA[ST25R3916_REG_GPT1] << 8) | sim.regA[ST25R3916_REG_GPT2]);
+	sim.ev[SIM_EV_GPT] = ((gpt == 0U) ? 0U : (sim.now + SIM_FC_TO_NS(8U * (uint32_t)gpt)));
+}
+
+static void simTriggerGpt(uint8_t trigger)
+{
+	if((sim.regA[ST25R3916_REG_TIMER_EMV_CONTROL] & ST25R3916_REG_TIMER_EMV_CONTROL_gptc_mask) == trigger) {
+		simStartGpt();
+	}
+}
+
+static void simStartNrt(void)
+{
+	uint32_t nrt;
+	uint32_t step;
+
+	nrt  = (uint32_t)((sim.regA[ST25R3916_REG_NO_RESPONSE_TIMER1] << 8) | sim.regA[ST25R3916_REG_NO_RESPONSE_TIMER2]);
+	step = (((sim.regA[ST25R3916_REG_TIMER_EMV_CONTROL] & ST25R3916_REG_TIMER_EMV_CONTROL_nrt_step) != 0U) ? 4096U : 64U);
+
+	/* A zero NRT never expires */
+	sim.ev[SIM_EV_NRT] = ((nrt == 0U) ? 0U : (sim.now + SIM_FC_TO_NS(nrt * step)));
+}
+
+/*
+******************************************************************************
+* Transmission and reception
+******************************************************************************
+*/
+static bool simPtaHandles(void);
+
+static bool simIsTarget(void)
+{
+	return ((sim.regA[ST25R3916_REG_MODE] & ST25R3916_REG_MODE_targ) == ST25R3916_REG_MODE_targ_targ);
+}
+
+/* Frame heard by the peer, its answer received after the given delay */
+static void simPeerAnswer(const uint8_t *frame, uint16_t bits, uint64_t delay)
+{
+	uint16_t respBits;
+
+	if(sim.peer == NULL) {
+		return;
+	}
+	respBits = sim.peer(sim.peerCtx, frame, bits, sim.rxFrame);
+	if((respBits == 0U) || (respBits > (ST25R3916_SIM_FRAME_MAX * 8U)) || ((sim.regA[ST25R3916_REG_OP_CONTROL] & ST25R3916_REG_OP_CONTROL_rx_en) == 0U)) {
+		return;
+	}
+	sim.rxBits = respBits;
+	sim.ev[SIM_EV_RXS] = (sim.now + delay);
+}
+
+static void simStartTx(uint8_t cmd)
+{
+	uint16_t ntx;
+	uint8_t  nbtx;
+
+	sim.ev[SIM_EV_RXS] = 0;
+	sim.ev[SIM_EV_RX]  = 0;
+	sim.rxAct  = false;
+	sim.txPos  = 0;
+	sim.txLast = false;
+	sim.stats.txFrames++;
+
+	if((cmd == ST25R3916_CMD_TRANSMIT_REQA) || (cmd == ST25R3916_CMD_TRANSMIT_WUPA)) {
+		/* 7 bits short frame, FIFO not used */
+		sim.txFrame[0]   = ((cmd == ST25R3916_CMD_TRANSMIT_REQA) ? 0x26U : 0x52U);
+		sim.txBits       = 7U;
+		sim.txFifoBytes  = 0U;
+		sim.txCrc        = false;
+		sim.txLast       = true;
+		sim.ev[SIM_EV_TX] = (sim.now + (8U * SIM_BIT_NS));
+		return;
+	}
+
+	ntx  = (uint16_t)((sim.regA[ST25R3916_REG_NUM_TX_BYTES1] << 5) | (sim.regA[ST25R3916_REG_NUM_TX_BYTES2] >> ST25R3916_REG_NUM_TX_BYTES2_ntx_shift));
+	nbtx = (sim.regA[ST25R3916_REG_NUM_TX_BYTES2] & ST25R3916_REG_NUM_TX_BYTES2_nbtx_mask);
+
+	sim.txBits      = (uint16_t)((ntx * 8U) + nbtx);
+	sim.txFifoBytes = (uint16_t)(ntx + ((nbtx != 0U) ? 1U : 0U));
+	sim.txCrc       = ((cmd == ST25R3916_CMD_TRANSMIT_WITH_CRC) && (nbtx == 0U));
+	sim.txLast      = (sim.txFifoBytes == 0U);
+	sim.ev[SIM_EV_TX] = (sim.now + SIM_BYTE_NS);
+}
+
+static void simEndTx(void)
+{
+	uint16_t len;
+
+	sim.ev[SIM_EV_TX] = 0;
+	simIrq(ST25R3916_IRQ_MASK_TXE);
+	simTriggerGpt(ST25R3916_REG_TIMER_EMV_CONTROL_gptc_etx_nfc);
+	simStartNrt();
+
+	len = (uint16_t)((sim.txBits + 7U) / 8U);
+	if(sim.txCrc) {
+		uint16_t crc = st25r3916SimCrcA(sim.txFrame, len);
+		sim.txFrame[len++] = (uint8_t)(crc & 0xFFU);
+		sim.txFrame[len++] = (uint8_t)(crc >> 8);
+		sim.txBits = (uint16_t)(len * 8U);
+	}
+
+	/* Nobody hears a frame sent without field, ours or the reader's one a target modulates */
+	if(simIsTarget() ? !sim.extField : ((sim.regA[ST25R3916_REG_OP_CONTROL] & ST25R3916_REG_OP_CONTROL_tx_en) == 0U)) {
+		return;
+	}
+	simPeerAnswer(sim.txFrame, sim.txBits, SIM_FDT_NS);
+}
+
+static void simTxByte(void)
+{
+	if(sim.txLast) {
+		simEndTx();
+		return;
+	}
+
+	if(sim.fifoCnt == 0U) {
+		/* The FIFO was not refilled in time, the frame is cut */
+		sim.fifoUnf = true;
+		sim.stats.fifoUnderflows++;
+		sim.txBits = (uint16_t)(sim.txPos * 8U);
+		sim.txCrc  = false;
+		simEndTx();
+		return;
+	}
+
+	sim.txFrame[sim.txPos++] = simFifoPop();
+	if(sim.fifoCnt == ST25R3916_SIM_FIFO_TX_WL) {
+		sim.stats.txWaterLevels++;
+		simIrq(ST25R3916_IRQ_MASK_FWL);
+	}
+
+	if(sim.txPos < sim.txFifoBytes) {
+		sim.ev[SIM_EV_TX] = (sim.now + SIM_BYTE_NS);
+	} else {
+		/* CRC and end of frame */
+		sim.txLast = true;
+		sim.ev[SIM_EV_TX] = (sim.now + (sim.txCrc ? (2U * SIM_BYTE_NS) : SIM_BIT_NS));
+	}
+}
+
+static void simRxStart(void)
+{
+	if(simIsTarget()) {
+		if(!sim.nfct) {
+			/* First reader frame since field on: 106kb/s recognised */
+			sim.nfct = true;
+			simIrq(ST25R3916_IRQ_MASK_NFCT);
+		}
+		if(simPtaHandles()) {
+			/* Automatic response, not seen in the FIFO */
+			sim.ev[SIM_EV_PTA] = (sim.now + ((uint64_t)((sim.rxBits + 7U) / 8U) * SIM_BYTE_NS));
+			return;
+		}
+	}
+
+	simIrq(ST25R3916_IRQ_MASK_RXS);
+	if((sim.regA[ST25R3916_REG_TIMER_EMV_CONTROL] & ST25R3916_REG_TIMER_EMV_CONTROL_nrt_emv) == 0U) {
+		sim.ev[SIM_EV_NRT] = 0;
+	}
+	simTriggerGpt(ST25R3916_REG_TIMER_EMV_CONTROL_gptc_srx);
+
+	sim.rxAct  = true;
+	sim.rxPos  = 0;
+	sim.fifoLb = 0;
+	sim.ev[SIM_EV_RX] = (sim.now + SIM_BYTE_NS);
+}
+
+static void simRxEnd(void)
+{
+	uint16_t len;
+	uint16_t crc;
+
+	sim.rxAct = false;
+	sim.fifoLb = (uint8_t)(sim.rxBits % 8U);
+
+	len = (uint16_t)((sim.rxBits + 7U) / 8U);
+	if((sim.regA[ST25R3916_REG_AUX] & ST25R3916_REG_AUX_no_crc_rx) == 0U) {
+		crc = ((len > 2U) ? st25r3916SimCrcA(sim.rxFrame, (uint16_t)(len - 2U)) : 0U);
+		if((sim.fifoLb != 0U) || (len <= 2U) ||
+		   (sim.rxFrame[len - 2U] != (uint8_t)(crc & 0xFFU)) || (sim.rxFrame[len - 1U] != (uint8_t)(crc >> 8))) {
+			simIrq(ST25R3916_IRQ_MASK_CRC);
+		}
+	}
+
+	sim.stats.rxFrames++;
+	simIrq(ST25R3916_IRQ_MASK_RXE);
+	simTriggerGpt(ST25R3916_REG_TIMER_EMV_CONTROL_gptc_erx);
+}
+
+static void simRxByte(void)
+{
+	simFifoPush(sim.rxFrame[sim.rxPos++]);
+	if(sim.fifoCnt == ST25R3916_SIM_FIFO_RX_WL) {
+		sim.stats.rxWaterLevels++;
+		simIrq(ST25R3916_IRQ_MASK_FWL);
+	}
+
+	if((sim.rxPos * 8U) < sim.rxBits) {
+		sim.ev[SIM_EV_RX] = (sim.now + SIM_BYTE_NS);
+	} else {
+		simRxEnd();
+	}
+}
+
+/*
+******************************************************************************
+* Passive target NFC-A anticollision, from the PT memory A config
+******************************************************************************
+*/
+#define SIM_PTM_SENS_RES   10U                  /* SENS_RES offset, after the NFCID1                */
+#define SIM_PTM_SEL_RES    12U                  /* SEL_RES of each cascade level                    */
+
+static bool simPtaHandles(void)
+{
+	return (((sim.regA[ST25R3916_REG_PASSIVE_TARGET] & ST25R3916_REG_PASSIVE_TARGET_d_106_ac_a) == 0U) &&
+	        (sim.ptaState != ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_active) &&
+	        (sim.ptaState != ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_active_x));
+}
+
+static bool simPtaFromHalt(void)
+{
+	return (sim.ptaState >= ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_halt);
+}
+
+/* Back to IDLE or HALT on an unexpected frame */
+static void simPtaReset(void)
+{
+	sim.ptaState = (simPtaFromHalt() ? ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_halt : ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_idle);
+	sim.ptaLevel = 0;
+}
+
+/* NFCID1 CLn and BCC of a cascade level */
+static void simPtaCln(uint8_t level, uint8_t *cln)
+{
+	bool single = ((sim.regA[ST25R3916_REG_AUX] & ST25R3916_REG_AUX_nfc_id_mask) == ST25R3916_REG_AUX_nfc_id_4bytes);
+
+	if(single || (level > 0U)) {
+		memcpy(cln, &sim.ptm[single ? 0U : 3U], 4);
+	} else {
+		cln[0] = 0x88U;
+		memcpy(&cln[1], sim.ptm, 3);
+	}
+	cln[4] = (uint8_t)(cln[0] ^ cln[1] ^ cln[2] ^ cln[3]);
+}
+
+static void simPtaFrame(void)
+{
+	const uint8_t *rx = sim.rxFrame;
+	uint8_t  tx[5];
+	uint16_t txLen = 0;
+	uint16_t crc;
+	uint8_t  levels;
+	uint8_t  sel;
+	bool     halt = simPtaFromHalt();
+
+	levels = (((sim.regA[ST25R3916_REG_AUX] & ST25R3916_REG_AUX_nfc_id_mask) == ST25R3916_REG_AUX_nfc_id_4bytes) ? 1U : 2U);
+	sel    = (uint8_t)(0x93U + (2U * sim.ptaLevel));
+
+	if(sim.rxBits == 7U) {
+		/* REQA from IDLE, WUPA from IDLE or HALT */
+		if((rx[0] == 0x52U) || ((rx[0] == 0x26U) && !halt)) {
+			sim.ptaState = (halt ? ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_ready_l1_x : ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_ready_l1);
+			sim.ptaLevel = 0;
+			memcpy(tx, &sim.ptm[SIM_PTM_SENS_RES], 2);
+			txLen = 2;
+		} else {
+			simPtaReset();
+		}
+	} else if((sim.ptaState == ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_idle) || (sim.ptaState == ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_halt)) {
+		/* Not woken up: frames are ignored */
+	} else if((sim.rxBits == 16U) && (rx[0] == sel) && (rx[1] == 0x20U)) {
+		/* SDD_RES, no CRC */
+		simPtaCln(sim.ptaLevel, tx);
+		txLen = 5;
+	} else if((sim.rxBits == 72U) && (rx[0] == sel) && (rx[1] == 0x70U)) {
+		simPtaCln(sim.ptaLevel, tx);
+		if(memcmp(&rx[2], tx, 5) != 0) {
+			simPtaReset();
+		} else {
+			tx[0] = sim.ptm[SIM_PTM_SEL_RES + sim.ptaLevel];
+			if((sim.ptaLevel + 1U) < levels) {
+				tx[0] |= 0x04U;
+				sim.ptaLevel++;
+				sim.ptaState = (halt ? ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_ready_l2_x : ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_ready_l2);
+			} else {
+				tx[0] &= (uint8_t)~0x04U;
+				sim.ptaState = (halt ? ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_active_x : ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_active);
+			}
+			crc = st25r3916SimCrcA(tx, 1);
+			tx[1] = (uint8_t)(crc & 0xFFU);
+			tx[2] = (uint8_t)(crc >> 8);
+			txLen = 3;
+		}
+	} else {
+		simPtaReset();
+	}
+
+	simIrq(ST25R3916_IRQ_MASK_RXE_PTA);
+	if(sim.ptaState == ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_active) {
+		simIrq(ST25R3916_IRQ_MASK_WU_A);
+	} else if(sim.ptaState == ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_active_x) {
+		simIrq(ST25R3916_IRQ_MASK_WU_A_X);
+	} else {
+		/* MISRA 15.7 - Empty else */
+	}
+
+	if(txLen > 0U) {
+		/* The reader answers once the automatic response is sent */
+		simPeerAnswer(tx, (uint16_t)(txLen * 8U), (SIM_FDT_NS + ((uint64_t)txLen * SIM_BYTE_NS) + SIM_FDT_NS));
+	}
+}
+
+/*
+******************************************************************************
+* Registers and commands
+******************************************************************************
+*/
+static void simSetDefault(void)
+{
+	uint8_t i;
+
+	memset(sim.regA, 0, sizeof(sim.regA));
+	memset(sim.regB, 0, sizeof(sim.regB));
+	memset(sim.regT, 0, sizeof(sim.regT));
+	memset(sim.irq, 0, sizeof(sim.irq));
+	for(i = 0; i < SIM_EV_NB; i++) {
+		if(i != SIM_EV_SPI) {
+			sim.ev[i] = 0;
+		}
+	}
+	sim.adResult = 0;
+	sim.oscOk    = false;
+	sim.rxAct    = false;
+	sim.ptaState = ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_power_off;
+	sim.ptaLevel = 0;
+	simFifoClear();
+}
+
+static void simCommand(uint8_t cmd)
+{
+	switch(cmd) {
+	case ST25R3916_CMD_SET_DEFAULT:
+		simSetDefault();
+		break;
+
+	case ST25R3916_CMD_STOP:
+		sim.ev[SIM_EV_TX]  = 0;
+		sim.ev[SIM_EV_RXS] = 0;
+		sim.ev[SIM_EV_RX]  = 0;
+		sim.ev[SIM_EV_GPT] = 0;
+		sim.ev[SIM_EV_NRT] = 0;
+		sim.rxAct = false;
+		simFifoClear();
+		break;
+
+	case ST25R3916_CMD_CLEAR_FIFO:
+		simFifoClear();
+		break;
+
+	case ST25R3916_CMD_TRANSMIT_WITH_CRC:
+	case ST25R3916_CMD_TRANSMIT_WITHOUT_CRC:
+	case ST25R3916_CMD_TRANSMIT_REQA:
+	case ST25R3916_CMD_TRANSMIT_WUPA:
+		simStartTx(cmd);
+		break;
+
+	case ST25R3916_CMD_INITIAL_RF_COLLISION:
+	case ST25R3916_CMD_RESPONSE_RF_COLLISION_N:
+		/* No external field around: the field goes on */
+		sim.ev[SIM_EV_APON] = (sim.now + SIM_APON_NS);
+		break;
+
+	case ST25R3916_CMD_START_GP_TIMER:
+		simStartGpt();
+		break;
+
+	case ST25R3916_CMD_START_WUP_TIMER:
+		sim.ev[SIM_EV_WUT] = (sim.now + SIM_WUT_NS);
+		break;
+
+	case ST25R3916_CMD_START_NO_RESPONSE_TIMER:
+		simStartNrt();
+		break;
+
+	case ST25R3916_CMD_STOP_NRT:
+		sim.ev[SIM_EV_NRT] = 0;
+		break;
+
+	case ST25R3916_CMD_GOTO_SENSE:
+		sim.ptaState = ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_idle;
+		sim.ptaLevel = 0;
+		break;
+
+	case ST25R3916_CMD_GOTO_SLEEP:
+		sim.ptaState = ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_halt;
+		sim.ptaLevel = 0;
+		break;
+
+	case ST25R3916_CMD_MEASURE_VDD:
+		sim.adResult = SIM_VDD_AD;
+		sim.ev[SIM_EV_DCT] = (sim.now + SIM_DCT_NS);
+		break;
+
+	case ST25R3916_CMD_MEASURE_AMPLITUDE:
+	case ST25R3916_CMD_MEASURE_PHASE:
+	case ST25R3916_CMD_MEASURE_CAPACITANCE:
+		sim.adResult = 0x80U;
+		sim.ev[SIM_EV_DCT] = (sim.now + SIM_DCT_NS);
+		break;
+
+	case ST25R3916_CMD_ADJUST_REGULATORS:
+	case ST25R3916_CMD_CALIBRATE_C_SENSOR:
+	case ST25R3916_CMD_CALIBRATE_DRIVER_TIMING:
+		sim.ev[SIM_EV_DCT] = (sim.now + SIM_ADJUST_NS);
+		break;
+
+	default:
+		/* Receiver masking, gain and RSSI resets, target commands: nothing to model */
+		break;
+	}
+}
+
+static uint8_t simReadReg(sim_space_t space, uint8_t reg)
+{
+	uint8_t val;
+
+	reg &= (SIM_REG_NB - 1U);
+	if(space == SIM_SPACE_TEST) {
+		return sim.regT[reg];
+	}
+	if(space == SIM_SPACE_B) {
+		return ((reg == (ST25R3916_REG_REGULATOR_RESULT & ~ST25R3916_SPACE_B)) ? SIM_REG_RESULT : sim.regB[reg]);
+	}
+
+	switch(reg) {
+	case ST25R3916_REG_IRQ_MAIN:
+	case ST25R3916_REG_IRQ_MAIN + 1U:
+	case ST25R3916_REG_IRQ_MAIN + 2U:
+	case ST25R3916_REG_IRQ_MAIN + 3U:
+		/* Reading an interrupt register clears it */
+		val = sim.irq[reg - ST25R3916_REG_IRQ_MAIN];
+		sim.irq[reg - ST25R3916_REG_IRQ_MAIN] = 0;
+		return val;
+
+	case ST25R3916_REG_FIFO_STATUS1:
+		return (uint8_t)(sim.fifoCnt & 0xFFU);
+
+	case ST25R3916_REG_FIFO_STATUS2:
+		val  = (uint8_t)(((sim.fifoCnt >> 8) << ST25R3916_REG_FIFO_STATUS2_fifo_b_shift) & ST25R3916_REG_FIFO_STATUS2_fifo_b_mask);
+		val |= (uint8_t)((sim.fifoLb << ST25R3916_REG_FIFO_STATUS2_fifo_lb_shift) & ST25R3916_REG_FIFO_STATUS2_fifo_lb_mask);
+		val |= (sim.fifoUnf ? ST25R3916_REG_FIFO_STATUS2_fifo_unf : 0U);
+		val |= (sim.fifoOvr ? ST25R3916_REG_FIFO_STATUS2_fifo_ovr : 0U);
+		return val;
+
+	case ST25R3916_REG_COLLISION_STATUS:
+		return 0;
+
+	case ST25R3916_REG_PASSIVE_TARGET_STATUS:
+		return sim.ptaState;
+
+	case ST25R3916_REG_NFCIP1_BIT_RATE:
+		val  = (uint8_t)(sim.regA[reg] & ~(ST25R3916_REG_NFCIP1_BIT_RATE_gpt_on | ST25R3916_REG_NFCIP1_BIT_RATE_nrt_on));
+		val |= ((sim.ev[SIM_EV_GPT] != 0U) ? ST25R3916_REG_NFCIP1_BIT_RATE_gpt_on : 0U);
+		val |= ((sim.ev[SIM_EV_NRT] != 0U) ? ST25R3916_REG_NFCIP1_BIT_RATE_nrt_on : 0U);
+		return val;
+
+	case ST25R3916_REG_AD_RESULT:
+		return sim.adResult;
+
+	case ST25R3916_REG_AUX_DISPLAY:
+		val  = (sim.oscOk ? ST25R3916_REG_AUX_DISPLAY_osc_ok : 0U);
+		val |= (sim.extField ? ST25R3916_REG_AUX_DISPLAY_efd_o : 0U);
+		val |= (sim.rxAct ? ST25R3916_REG_AUX_DISPLAY_rx_act : 0U);
+		val |= (((sim.regA[ST25R3916_REG_OP_CONTROL] & ST25R3916_REG_OP_CONTROL_tx_en) != 0U) ? ST25R3916_REG_AUX_DISPLAY_tx_on : 0U);
+		val |= (((sim.regA[ST25R3916_REG_OP_CONTROL] & ST25R3916_REG_OP_CONTROL_rx_en) != 0U) ? ST25R3916_REG_AUX_DISPLAY_rx_on : 0U);
+		return val;
+
+	case ST25R3916_REG_IC_IDENTITY:
+		return SIM_IC_IDENTITY;
+
+	default:
+		return sim.regA[reg];
+	}
+}
+
+static void simWriteReg(sim_space_t space, uint8_t reg, uint8_t val)
+{
+	uint8_t old;
+
+	reg &= (SIM_REG_NB - 1U);
+	if(sim.writeHook != NULL) {
+		sim.writeHook(sim.writeCtx, (uint8_t)space, reg, val);
+	}
+	if(space == SIM_SPACE_TEST) {
+		sim.regT[reg] = val;
+		return;
+	}
+	if(space == SIM_SPACE_B) {
+		sim.regB[reg] = val;
+		return;
+	}
+
+	old = sim.regA[reg];
+	sim.regA[reg] = val;
+
+	if(reg == ST25R3916_REG_OP_CONTROL) {
+		if(((old & ST25R3916_REG_OP_CONTROL_en) == 0U) && ((val & ST25R3916_REG_OP_CONTROL_en) != 0U)) {
+			sim.ev[SIM_EV_OSC] = (sim.now + SIM_OSC_NS);
+		} else if((val & ST25R3916_REG_OP_CONTROL_en) == 0U) {
+			sim.ev[SIM_EV_OSC] = 0;
+			sim.oscOk = false;
+		}
+	}
+}
+
+/*
+******************************************************************************
+* Virtual clock
+******************************************************************************
+*/
+static void simSpiComplete(void);
+
+static void simEvent(sim_ev_t ev)
+{
+	switch(ev) {
+	case SIM_EV_OSC:
+		sim.oscOk = true;
+		simIrq(ST25R3916_IRQ_MASK_OSC);
+		break;
+
+	case SIM_EV_WUT:
+		simIrq(ST25R3916_IRQ_MASK_WT);
+		break;
+
+	case SIM_EV_GPT:
+		simIrq(ST25R3916_IRQ_MASK_GPE);
+		break;
+
+	case SIM_EV_NRT:
+		simIrq(ST25R3916_IRQ_MASK_NRE);
+		break;
+
+	case SIM_EV_APON:
+		sim.regA[ST25R3916_REG_OP_CONTROL] |= ST25R3916_REG_OP_CONTROL_tx_en;
+		simIrq(ST25R3916_IRQ_MASK_APON);
+		sim.ev[SIM_EV_CAT] = (sim.now + SIM_CAT_NS);
+		break;
+
+	case SIM_EV_CAT:
+		simIrq(ST25R3916_IRQ_MASK_CAT);
+		break;
+
+	case SIM_EV_DCT:
+		simIrq(ST25R3916_IRQ_MASK_DCT);
+		break;
+
+	case SIM_EV_TX:
+		simTxByte();
+		break;
+
+	case SIM_EV_RXS:
+		simRxStart();
+		break;
+
+	case SIM_EV_RX:
+		simRxByte();
+		break;
+
+	case SIM_EV_PTA:
+		simPtaFrame();
+		break;
+
+	case SIM_EV_SPI:
+		simSpiComplete();
+		break;
+
+	default:
+		break;
+	}
+}
+
+/* Run the chip up to the given time, events in time order */
+static void simRunUntil(uint64_t t)
+{
+	uint64_t tn;
+	int next;
+	int i;
+
+	for(;;) {
+		next = -1;
+		tn   = t;
+		for(i = 0; i < (int)SIM_EV_NB; i++) {
+			if((sim.ev[i] != 0U) && (sim.ev[i] <= tn)) {
+				tn   = sim.ev[i];
+				next = i;
+			}
+		}
+		if(next < 0) {
+			break;
+		}
+		if(tn > sim.now) {
+			sim.now = tn;
+		}
+		sim.ev[next] = 0;
+		simEvent((sim_ev_t)next);
+	}
+
+	if(t > sim.now) {
+		sim.now = t;
+	}
+}
+
+/* What the firmware IRQ thread does once it gets the com mutex */
+static void simDispatch(void)
+{
+	while(!sim.inIsr && (globalCommProtectCnt == 0U) && st25r3916SimIntIsHigh()) {
+		sim.inIsr = true;
+		sim.stats.irqs++;
+		st25r3916Isr();
+		sim.inIsr = false;
+	}
+}
+
+/*
+******************************************************************************
+* SPI
+******************************************************************************
+*/
+static uint8_t simSpiByte(uint8_t tx)
+{
+	sim.stats.spiBytes++;
+
+	switch(sim.mode) {
+	case SIM_SPI_IDLE:
+		if(tx == ST25R3916_CMD_SPACE_B_ACCESS) {
+			sim.space = SIM_SPACE_B;
+		} else if(tx == ST25R3916_CMD_TEST_ACCESS) {
+			sim.space = SIM_SPACE_TEST;
+		} else if((tx & 0xC0U) == 0x00U) {
+			sim.mode = SIM_SPI_WRITE;
+			sim.addr = (tx & 0x3FU);
+		} else if((tx & 0xC0U) == 0x40U) {
+			sim.mode = SIM_SPI_READ;
+			sim.addr = (tx & 0x3FU);
+		} else if(tx == 0x80U) {
+			sim.mode = SIM_SPI_FIFO_LOAD;
+		} else if(tx == 0x9FU) {
+			sim.mode = SIM_SPI_FIFO_READ;
+		} else if((tx == 0xA0U) || (tx == 0xA8U) || (tx == 0xACU)) {
+			/* A config, F config and TSN data follow each other */
+			sim.mode   = SIM_SPI_PTM_LOAD;
+			sim.ptmPos = ((tx == 0xA0U) ? 0U : ((tx == 0xA8U) ? ST25R3916_PTM_A_LEN : (ST25R3916_PTM_A_LEN + ST25R3916_PTM_F_LEN)));
+		} else if(tx == 0xBFU) {
+			sim.mode   = SIM_SPI_PTM_READ;
+			sim.ptmPos = 0;
+		} else {
+			sim.mode = SIM_SPI_CMD;
+			simCommand(tx);
+		}
+		return 0;
+
+	case SIM_SPI_WRITE:
+		simWriteReg(sim.space, sim.addr++, tx);
+		return 0;
+
+	case SIM_SPI_READ:
+		return simReadReg(sim.space, sim.addr++);
+
+	case SIM_SPI_FIFO_LOAD:
+		simFifoPush(tx);
+		return 0;
+
+	case SIM_SPI_FIFO_READ:
+		return simFifoPop();
+
+	case SIM_SPI_PTM_LOAD:
+		if(sim.ptmPos < ST25R3916_PTM_LEN) {
+			sim.ptm[sim.ptmPos++] = tx;
+		}
+		return 0;
+
+	case SIM_SPI_PTM_READ:
+		return ((sim.ptmPos < ST25R3916_PTM_LEN) ? sim.ptm[sim.ptmPos++] : 0U);
+
+	default:
+		return 0;
+	}
+}
+
+static void simSpiComplete(void)
+{
+	uint16_t i;
+	uint8_t rx;
+	void (*cb)(void *param);
+
+	for(i = 0; i < sim.bgLen; i++) {
+		rx = simSpiByte((sim.bgTx != NULL) ? sim.bgTx[i] : 0U);
+		if(sim.bgRx != NULL) {
+			sim.bgRx[i] = rx;
+		}
+	}
+
+	cb = sim.bgCb;
+	sim.bgCb  = NULL;
+	sim.bgLen = 0;
+	if(cb != NULL) {
+		cb(sim.bgParam);
+	}
+}
+
+void st25r3916SimSelect(void)
+{
+	sim.cs    = true;
+	sim.mode  = SIM_SPI_IDLE;
+	sim.space = SIM_SPACE_A;
+	sim.stats.spiTransactions++;
+}
+
+void st25r3916SimDeselect(void)
+{
+	sim.cs   = false;
+	sim.mode = SIM_SPI_IDLE;
+}
+
+int st25r3916SimSpiTxRx(const uint8_t *txData, uint8_t *rxData, uint16_t length)
+{
+	uint16_t i;
+	uint8_t rx;
+
+	/* A failed transfer clocks nothing, as a timed out polled transfer */
+	if(sim.spiFail > 0U) {
+		sim.spiFail--;
+		return 1;
+	}
+
+	for(i = 0; i < length; i++) {
+		rx = simSpiByte((txData != NULL) ? txData[i] : 0U);
+		if(rxData != NULL) {
+			rxData[i] = rx;
+		}
+		simRunUntil(sim.now + SIM_SPI_BYTE_NS);
+	}
+	return HAL_OK;
+}
+
+int st25r3916SimSpiTxRxStart(const uint8_t *txData, uint8_t *rxData, uint16_t length, void (*cb)(void *param), void *param)
+{
+	if(sim.ev[SIM_EV_SPI] != 0U) {
+		return 1;
+	}
+
+	/* The bytes are clocked when the transfer ends */
+	sim.bgTx    = txData;
+	sim.bgRx    = rxData;
+	sim.bgLen   = length;
+	sim.bgCb    = cb;
+	sim.bgParam = param;
+	sim.stats.spiStreams++;
+	sim.ev[SIM_EV_SPI] = (sim.now + ((uint64_t)length * SIM_SPI_BYTE_NS));
+	return HAL_OK;
+}
+
+int st25r3916SimSpiWait(void)
+{
+	if(sim.ev[SIM_EV_SPI] != 0U) {
+		simRunUntil(sim.ev[SIM_EV_SPI]);
+	}
+	return HAL_OK;
+}
+
+/*
+******************************************************************************
+* Platform hooks
+******************************************************************************
+*/
+bool st25r3916SimIntIsHigh(void)
+{
+	return ((sim.irq[0] | sim.irq[1] | sim.irq[2] | sim.irq[3]) != 0U);
+}
+
+void st25r3916SimPoll(void)
+{
+	simRunUntil(sim.now + SIM_POLL_NS);
+	simDispatch();
+}
+
+void st25r3916SimProtectComm(void)
+{
+	globalCommProtectCnt++;
+}
+
+void st25r3916SimUnprotectComm(void)
+{
+	if(globalCommProtectCnt > 0U) {
+		globalCommProtectCnt--;
+	}
+	simDispatch();
+}
+
+void st25r3916SimDelayMs(uint32_t delay_ms)
+{
+	simRunUntil(sim.now + ((uint64_t)delay_ms * 1000000U));
+	simDispatch();
+}
+
+/*
+******************************************************************************
+* Simulator control
+******************************************************************************
+*/
+void st25r3916SimReset(void)
+{
+	memset(&sim, 0, sizeof(sim));
+	sim.now = SIM_START_NS;
+	globalCommProtectCnt = 0;
+	simSetDefault();
+}
+
+void st25r3916SimSetPeer(st25r3916SimPeerFn fn, void *ctx)
+{
+	sim.peer    = fn;
+	sim.peerCtx = ctx;
+}
+
+/* External reader field, for listen mode */
+void st25r3916SimSetExtField(bool on)
+{
+	if(on == sim.extField) {
+		return;
+	}
+	sim.extField = on;
+	sim.nfct     = false;
+	if(!on) {
+		sim.ptaState = ST25R3916_REG_PASSIVE_TARGET_STATUS_pta_st_power_off;
+		sim.ptaLevel = 0;
+	}
+	simIrq(on ? ST25R3916_IRQ_MASK_EON : ST25R3916_IRQ_MASK_EOF);
+	simDispatch();
+}
+
+/* First frame of the external reader, the next ones answer what the chip sends */
+void st25r3916SimReaderSend(const uint8_t *frame, uint16_t bits)
+{
+	if(!sim.extField || (bits == 0U) || (bits > (ST25R3916_SIM_FRAME_MAX * 8U))) {
+		return;
+	}
+	memcpy(sim.rxFrame, frame, ((bits + 7U) / 8U));
+	sim.rxBits = bits;
+	sim.ev[SIM_EV_RXS] = (sim.now + SIM_FDT_NS);
+}
+
+void st25r3916SimSetWriteHook(st25r3916SimWriteFn fn, void *ctx)
+{
+	sim.writeHook = fn;
+	sim.writeCtx  = ctx;
+}
+
+/* Raw register access, without the side effects of a SPI write */
+void st25r3916SimGetRegs(st25r3916SimRegs *regs)
+{
+	memcpy(regs->reg[SIM_SPACE_A], sim.regA, SIM_REG_NB);
+	memcpy(regs->reg[SIM_SPACE_B], sim.regB, SIM_REG_NB);
+	memcpy(regs->reg[SIM_SPACE_TEST], sim.regT, SIM_REG_NB);
+}
+
+void st25r3916SimSetRegs(const st25r3916SimRegs *regs)
+{
+	memcpy(sim.regA, regs->reg[SIM_SPACE_A], SIM_REG_NB);
+	memcpy(sim.regB, regs->reg[SIM_SPACE_B], SIM_REG_NB);
+	memcpy(sim.regT, regs->reg[SIM_SPACE_TEST], SIM_REG_NB);
+}
+
+void st25r3916SimFailSpi(uint32_t count)
+{
+	sim.spiFail = count;
+}
+
+void st25r3916SimGetStats(st25r3916SimStats *stats)
+{
+	*stats = sim.stats;
+}
+
+uint64_t st25r3916SimGetTimeNs(void)
+{
+	return sim.now;
+}
+
+uint16_t st25r3916SimCrcA(const uint8_t *buf, uint16_t len)
+{
+	return rfalCrcCalculateCcitt(0x6363U, buf, len);
+}
+
+/*
+******************************************************************************
+* timer.h on the virtual clock, replaces hal/src/timer.c
+******************************************************************************
+*/
+uint32_t timerGetUs(void)
+{
+	/* Every time read is a busy loop iteration */
+	st25r3916SimPoll();
+	return (uint32_t)(sim.now / 1000U);
+}
+
+uint32_t timerCalculateTimer(uint16_t time)
+{
+	return timerCalculateTimerUs((uint32_t)time * 1000U);
+}
+
+uint32_t timerCalculateTimerUs(uint32_t time)
+{
+	return (timerGetUs() + time);
+}
+
+bool timerGetNextExpiry(uint32_t *remaining)
+{
+	(void)remaining;
+	return false;
+}
+
+bool timerIsExpired(uint32_t timer)
+{
+	return ((int32_t)(timer - timerGetUs()) < 0);
+}
+
+void timerDelay(uint16_t time)
+{
+	st25r3916SimDelayMs(time);
+}
+
+void timerDelayUs(uint32_t time)
+{
+	simRunUntil(sim.now + ((uint64_t)time * 1000U));
+	simDispatch();
+}
+
+void timerStopwatchStart(void)
+{
+	timerStopwatchTick = timerGetUs();
+}
+
+uint32_t timerStopwatchMeasure(void)
+{
+	return (timerStopwatchMeasureUs() / 1000U);
+}
+
+uint32_t timerStopwatchMeasureUs(void)
+{
+	return (uint32_t)(timerGetUs() - timerStopwatchTick);
+}
@@ -0,0 +1,122 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ST25R3916_SIM_H
+#define ST25R3916_SIM_H
+
+/*
+ * Host model of the ST25R3916 as seen by RFAL through platform.h.
+ *
+ * It decodes the SPI protocol (registers in space A/B, test registers,
+ * FIFO load/read, direct commands) and keeps the 512 bytes FIFO, the
+ * interrupt status/mask registers and the INT line. Timers, field on,
+ * transmission and reception run on a virtual clock, at 106kb/s air
+ * timing. Frames sent by the reader are handed to a scripted peer whose
+ * answer is fed back into the FIFO.
+ *
+ * In target mode the peer is the external reader: st25r3916SimSetExtField()
+ * turns its field on and st25r3916SimReaderSend() sends its first frame,
+ * the next ones being the peer answers to what the chip sends. The NFC-A
+ * anticollision is answered from the passive target memory until the
+ * target is selected, as the chip automatic responses do.
+ *
+ * The ST25R3916 IRQ is processed the way the firmware IRQ thread does:
+ * st25r3916Isr() runs whenever the INT line is high and the
+ * communication channel is not owned.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ST25R3916_SIM_FIFO_DEPTH     512U  /* Bytes in the FIFO                                  */
+#define ST25R3916_SIM_FIFO_TX_WL     200U  /* FWL while Tx when the FIFO drains to this level    */
+#define ST25R3916_SIM_FIFO_RX_WL     300U  /* FWL while Rx when the FIFO fills up to this level  */
+#define ST25R3916_SIM_FRAME_MAX      1024U /* Longest frame exchanged with the peer, in bytes    */
+
+/** \brief Scripted peer answering the frames sent on the field: the tag, or
+ *         the reader when the chip is in target mode
+ *
+ *  \param ctx      : peer context given to st25r3916SimSetPeer()
+ *  \param rx       : frame received by the peer, CRC included when sent
+ *  \param rxBits   : length of the received frame in bits
+ *  \param tx       : answer of the peer, CRC included if any
+ *
+ *  \return : length of the answer in bits, 0 for no answer
+ */
+typedef uint16_t (*st25r3916SimPeerFn)(void *ctx, const uint8_t *rx, uint16_t rxBits, uint8_t *tx);
+
+/** \brief Register write clocked on SPI
+ *
+ *  \param ctx      : context given to st25r3916SimSetWriteHook()
+ *  \param space    : ST25R3916_SIM_SPACE_A, _B or _TEST
+ *  \param reg      : register address in its space
+ *  \param val      : value written
+ */
+typedef void (*st25r3916SimWriteFn)(void *ctx, uint8_t space, uint8_t reg, uint8_t val);
+
+#define ST25R3916_SIM_SPACE_A        0U
+#define ST25R3916_SIM_SPACE_B        1U
+#define ST25R3916_SIM_SPACE_TEST     2U
+#define ST25R3916_SIM_SPACE_NB       3U
+#define ST25R3916_SIM_REG_NB         64U   /* Registers per space                                */
+
+/** \brief Register contents of every space, indexed by ST25R3916_SIM_SPACE_* */
+typedef struct {
+	uint8_t reg[ST25R3916_SIM_SPACE_NB][ST25R3916_SIM_REG_NB];
+} st25r3916SimRegs;
+
+/** \brief Counters kept by the simulator */
+typedef struct {
+	uint32_t spiTransactions;  /* Chip select cycles                        */
+	uint32_t spiBytes;         /* Bytes clocked on SPI                      */
+	uint32_t spiStreams;       /* Background SPI transfers                  */
+	uint32_t irqs;             /* st25r3916Isr() calls                      */
+	uint32_t txFrames;         /* Frames transmitted                        */
+	uint32_t rxFrames;         /* Frames received                           */
+	uint32_t txWaterLevels;    /* FWL raised while transmitting             */
+	uint32_t rxWaterLevels;    /* FWL raised while receiving                */
+	uint32_t fifoUnderflows;   /* Tx FIFO ran empty before the frame end    */
+	uint32_t fifoOverflows;    /* Rx bytes lost on a full FIFO              */
+	uint16_t fifoMax;          /* Highest FIFO level seen                   */
+} st25r3916SimStats;
+
+void st25r3916SimReset(void);
+void st25r3916SimSetPeer(st25r3916SimPeerFn fn, void *ctx);
+void st25r3916SimFailSpi(uint32_t count);
+void st25r3916SimSetExtField(bool on);
+void st25r3916SimReaderSend(const uint8_t *frame, uint16_t bits);
+void st25r3916SimSetWriteHook(st25r3916SimWriteFn fn, void *ctx);
+void st25r3916SimGetRegs(st25r3916SimRegs *regs);
+void st25r3916SimSetRegs(const st25r3916SimRegs *regs);
+void st25r3916SimGetStats(st25r3916SimStats *stats);
+uint64_t st25r3916SimGetTimeNs(void);
+uint16_t st25r3916SimCrcA(const uint8_t *buf, uint16_t len);
+
+/* Platform hooks, see platform.h */
+void st25r3916SimPoll(void);
+bool st25r3916SimIntIsHigh(void);
+void st25r3916SimSelect(void);
+void st25r3916SimDeselect(void);
+int st25r3916SimSpiTxRx(const uint8_t *txData, uint8_t *rxData, uint16_t length);
+int st25r3916SimSpiTxRxStart(const uint8_t *txData, uint8_t *rxData, uint16_t length, void (*cb)(void *param), void *param);
+int st25r3916SimSpiWait(void);
+void st25r3916SimProtectComm(void);
+void st25r3916SimUnprotectComm(void);
+void st25r3916SimDelayMs(uint32_t delay_ms);
+
+#endif /* ST25R3916_SIM_H */
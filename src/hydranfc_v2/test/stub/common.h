@@ -0,0 +1,68 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _COMMON_H_
+#define _COMMON_H_
+
+/*
+ * Host stand-in of src/common/common.h: the part of the HydraBus console
+ * API used by the HydraNFC v2 code built in nfc_bench, without ChibiOS.
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "commands.h"
+
+#ifndef TRUE
+#define TRUE	true
+#endif
+#ifndef FALSE
+#define FALSE	false
+#endif
+
+#define ARRAY_SIZE(x) (sizeof((x))/sizeof((x)[0]))
+
+#define BIT0    (1<<0)
+#define BIT1    (1<<1)
+#define BIT2    (1<<2)
+#define BIT3    (1<<3)
+#define BIT4    (1<<4)
+#define BIT5    (1<<5)
+#define BIT6    (1<<6)
+#define BIT7    (1<<7)
+#define BIT8    (1<<8)
+
+#ifndef MIN
+#define MIN(a, b) (a < b ? a : b)
+#endif
+
+/* Console output goes to out, discarded when NULL */
+typedef struct hydra_console {
+	FILE *out;
+} t_hydra_console;
+
+void cprintf(t_hydra_console *con, const char *fmt, ...);
+bool buf_ascii2hex(uint8_t *ascii_buf, uint8_t *hex_buf, uint32_t *hex_buflen);
+void pretty_print_hex_buf(t_hydra_console *con, uint8_t *buffer, uint16_t len);
+uint8_t hydrabus_ubtn(void);
+
+#endif /* _COMMON_H_ */
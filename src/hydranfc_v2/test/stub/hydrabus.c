@@ -0,0 +1,91 @@
+/*
+ * HydraBus/HydraNFC v2
+ *
+ * Copyright (C) 2020-2021 Benjamin VERNOUX
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Host implementation of the HydraBus services used by the HydraNFC v2
+ * code: console output, user button and the RFAL worker sleep of
+ * hydranfc_v2.c, on the simulated ST25R3916.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "platform.h"
+#include "common.h"
+#include "hydranfc_v2.h"
+
+void cprintf(t_hydra_console *con, const char *fmt, ...)
+{
+	va_list va_args;
+
+	if ((con == NULL) || (con->out == NULL))
+		return;
+	va_start(va_args, fmt);
+	vfprintf(con->out, fmt, va_args);
+	va_end(va_args);
+}
+
+bool buf_ascii2hex(uint8_t *ascii_buf, uint8_t *hex_buf, uint32_t *hex_buflen)
+{
+	int ii = 0, io = 0;
+
+	if (ascii_buf == NULL || hex_buf == NULL || hex_buflen == NULL)
+		return false;
+
+	while (ascii_buf[ii]) {
+		if (sscanf((char *)&ascii_buf[ii], "%02hhx", &hex_buf[io]) != 1)
+			return false;
+		ii += 2;
+		io++;
+	}
+	*hex_buflen = io;
+	return true;
+}
+
+void pretty_print_hex_buf(t_hydra_console *con, uint8_t *buffer, uint16_t len)
+{
+	uint16_t i;
+
+	for (i = 0; i < len; i++)
+		cprintf(con, "%02X ", buffer[i]);
+	cprintf(con, "\r\n");
+}
+
+/* Nobody presses it, the callers run until their own end */
+uint8_t hydrabus_ubtn(void)
+{
+	return 0;
+}
+
+/* Sleep until the ST25R3916 IRQ ran or max_us elapsed, on the virtual clock */
+bool hydranfc_v2_worker_wait(uint32_t max_us)
+{
+	st25r3916SimStats stats;
+	uint32_t irqs, start;
+
+	st25r3916SimGetStats(&stats);
+	irqs = stats.irqs;
+	start = timerGetUs();
+	do {
+		st25r3916SimGetStats(&stats);
+		if (stats.irqs != irqs)
+			return true;
+	} while ((timerGetUs() - start) < max_us);
+	return false;
+}